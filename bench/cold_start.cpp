@@ -0,0 +1,240 @@
+// Measures the cold-start latency of cpp_init.
+//
+//   cpp_init_cold_start [--runs N] <path to cpp_init>
+//
+// time-to-first-prompt: from fork() until the first byte of the first prompt
+//                       arrives on the stdout pipe.
+// end-to-end:           from fork() until cpp_init exits after generating an
+//                       application from answers written to its stdin, in a
+//                       fresh temporary directory.
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// An empty application without any of the optional modules.
+constexpr std::string_view kAnswers{
+    "2\nbench_app\nbench_app\nbench\nbench\n17\n1\nn\nn\nn\nn\n"};
+
+struct Child {
+  pid_t pid{-1};
+  int in{-1};
+  int out{-1};
+};
+
+// Starts cpp_init in dir with pipes for stdin and stdout; stderr is
+// discarded.
+auto Spawn(const char* program, const std::filesystem::path& dir) -> Child {
+  int in[2];
+  int out[2];
+  if (pipe(in) != 0) {
+    return {};
+  }
+  if (pipe(out) != 0) {
+    close(in[0]);
+    close(in[1]);
+    return {};
+  }
+  const pid_t pid = fork();
+  if (pid == 0) {
+    dup2(in[0], STDIN_FILENO);
+    dup2(out[1], STDOUT_FILENO);
+    if (const int null = open("/dev/null", O_WRONLY); null >= 0) {
+      dup2(null, STDERR_FILENO);
+      close(null);
+    }
+    close(in[0]);
+    close(in[1]);
+    close(out[0]);
+    close(out[1]);
+    if (chdir(dir.c_str()) != 0) {
+      _exit(127);
+    }
+    execl(program, program, static_cast<char*>(nullptr));
+    _exit(127);
+  }
+  close(in[0]);
+  close(out[1]);
+  if (pid < 0) {
+    close(in[1]);
+    close(out[0]);
+    return {};
+  }
+  return {pid, in[1], out[0]};
+}
+
+auto Wait(pid_t pid) -> int {
+  int status{0};
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return -1;
+    }
+  }
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+auto WriteAll(int fd, std::string_view text) -> bool {
+  while (!text.empty()) {
+    const auto written = write(fd, text.data(), text.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    text.remove_prefix(static_cast<std::size_t>(written));
+  }
+  return true;
+}
+
+// Reads and discards the output of the child until it closes stdout.
+auto Drain(int fd) -> void {
+  char buffer[4096];
+  while (true) {
+    const auto count = read(fd, buffer, sizeof(buffer));
+    if (count == 0 || (count < 0 && errno != EINTR)) {
+      return;
+    }
+  }
+}
+
+auto Micros(Clock::duration duration) -> double {
+  return std::chrono::duration<double, std::micro>(duration).count();
+}
+
+// Returns a negative value on failure.
+auto TimeToFirstPrompt(const char* program,
+                       const std::filesystem::path& dir) -> double {
+  const auto start = Clock::now();
+  const auto child = Spawn(program, dir);
+  if (child.pid < 0) {
+    return -1.0;
+  }
+  char c{0};
+  ssize_t count{0};
+  do {
+    count = read(child.out, &c, 1);
+  } while (count < 0 && errno == EINTR);
+  const auto end = Clock::now();
+  // Ends the input, cpp_init exits without generating anything.
+  close(child.in);
+  Drain(child.out);
+  close(child.out);
+  Wait(child.pid);
+  return count == 1 ? Micros(end - start) : -1.0;
+}
+
+auto EndToEnd(const char* program, const std::filesystem::path& dir)
+    -> double {
+  const auto start = Clock::now();
+  const auto child = Spawn(program, dir);
+  if (child.pid < 0) {
+    return -1.0;
+  }
+  const bool written = WriteAll(child.in, kAnswers);
+  close(child.in);
+  Drain(child.out);
+  close(child.out);
+  const int status = Wait(child.pid);
+  const auto end = Clock::now();
+  return written && status == 0 ? Micros(end - start) : -1.0;
+}
+
+auto Percentile(const std::vector<double>& sorted, double p) -> double {
+  const auto index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+auto Report(std::string_view name, std::vector<double>& samples) -> void {
+  std::sort(samples.begin(), samples.end());
+  std::printf("%-22.*s min %8.0f us  median %8.0f us  p90 %8.0f us  max %8.0f "
+              "us\n",
+              static_cast<int>(name.size()), name.data(), samples.front(),
+              Percentile(samples, 0.5), Percentile(samples, 0.9),
+              samples.back());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  long runs{20};
+  int i{1};
+  if (argc == 4 && std::string_view{argv[1]} == "--runs") {
+    const std::string_view text{argv[2]};
+    const auto [end, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), runs);
+    if (ec != std::errc{} || end != text.data() + text.size() || runs <= 0) {
+      std::fprintf(stderr, "cpp_init_cold_start: invalid --runs: %s\n",
+                   argv[2]);
+      return EXIT_FAILURE;
+    }
+    i = 3;
+  }
+  if (argc != i + 1) {
+    std::fprintf(stderr,
+                 "usage: cpp_init_cold_start [--runs N] <path to cpp_init>\n");
+    return EXIT_FAILURE;
+  }
+  const auto program = std::filesystem::absolute(argv[i]).string();
+
+  std::string dir_template{
+      (std::filesystem::temp_directory_path() / "cpp_init_cold_start.XXXXXX")
+          .string()};
+  if (mkdtemp(dir_template.data()) == nullptr) {
+    std::perror("cpp_init_cold_start: mkdtemp");
+    return EXIT_FAILURE;
+  }
+  const std::filesystem::path root{dir_template};
+
+  std::vector<double> first_prompt;
+  std::vector<double> end_to_end;
+  bool ok{true};
+  for (long run{0}; run < runs && ok; ++run) {
+    const auto elapsed = TimeToFirstPrompt(program.c_str(), root);
+    if (elapsed < 0) {
+      std::fprintf(stderr, "cpp_init_cold_start: no prompt from %s\n",
+                   program.c_str());
+      ok = false;
+      break;
+    }
+    first_prompt.push_back(elapsed);
+  }
+  for (long run{0}; run < runs && ok; ++run) {
+    const auto dir = root / std::to_string(run);
+    std::error_code error_code;
+    std::filesystem::create_directory(dir, error_code);
+    const auto elapsed = error_code ? -1.0 : EndToEnd(program.c_str(), dir);
+    if (elapsed < 0) {
+      std::fprintf(stderr, "cpp_init_cold_start: generation failed in %s\n",
+                   dir.c_str());
+      ok = false;
+      break;
+    }
+    end_to_end.push_back(elapsed);
+  }
+  std::error_code error_code;
+  std::filesystem::remove_all(root, error_code);
+  if (!ok) {
+    return EXIT_FAILURE;
+  }
+
+  std::printf("%s: %ld runs\n", program.c_str(), runs);
+  Report("time-to-first-prompt", first_prompt);
+  Report("end-to-end generation", end_to_end);
+  return EXIT_SUCCESS;
+}
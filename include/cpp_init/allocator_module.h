@@ -0,0 +1,20 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_ALLOCATOR_MODULE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_ALLOCATOR_MODULE_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "cpp_init/params.h"
+
+namespace ci {
+
+// Writes cmake/allocator.cmake, include/<name>/allocator_stats.h,
+// src/allocator_stats.cpp and bench/alloc_bench.cpp. The CMake module selects
+// the allocator with the <NAME>_ALLOCATOR cache variable (system, jemalloc,
+// mimalloc or tcmalloc) and links it through the <name>_allocator target.
+auto WriteAllocatorModule(const std::filesystem::path& project_path,
+                          const AppParams* param) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_ALLOCATOR_MODULE_H
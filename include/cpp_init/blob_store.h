@@ -0,0 +1,66 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_BLOB_STORE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_BLOB_STORE_H
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace ci {
+
+// How a file with already written content is placed.
+enum class LinkMode : uint8_t {
+  // Write the content again.
+  kCopy,
+  // Share the extents of the first copy with ioctl(FICLONE) (btrfs, xfs).
+  // Copy-on-write, so editing one generated file doesn't affect the others.
+  kReflink,
+  // Hardlink to the first copy. Editing one file in place changes them all.
+  kHardlink,
+};
+
+struct BlobStoreStats {
+  uint64_t files{0};
+  uint64_t blobs{0};
+  uint64_t reflinks{0};
+  uint64_t hardlinks{0};
+  uint64_t copies{0};
+  uint64_t bytes_written{0};
+  uint64_t bytes_saved{0};
+};
+
+// Content addressed writer for files that are byte-identical across generated
+// projects. The first file with a given content is written normally; later
+// files with the same content are reflinked or hardlinked to it. When the file
+// system doesn't support the requested link, the content is written again.
+// Thread safe.
+class BlobStore {
+ public:
+  explicit BlobStore(LinkMode mode) : mode_{mode} {}
+
+  auto Write(const std::filesystem::path& path, std::string_view content)
+      -> uint8_t;
+  auto Stats() const -> BlobStoreStats;
+
+ private:
+  auto Place(const std::filesystem::path& source,
+             const std::filesystem::path& path, std::string_view content)
+      -> uint8_t;
+
+  LinkMode mode_;
+  std::atomic<bool> reflink_supported_{true};
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, std::filesystem::path> blobs_;
+  BlobStoreStats stats_;
+};
+
+// Writes content to path, through the store when it isn't a nullptr.
+auto WriteSharedFile(const std::filesystem::path& path,
+                     std::string_view content, BlobStore* store) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_BLOB_STORE_H
@@ -0,0 +1,23 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_BUILD_CONFIG_MODULE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_BUILD_CONFIG_MODULE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace ci {
+
+class BlobStore;
+
+// Writes build_config.h.in and cmake/build_config.cmake. The CMake functions
+// build_config() and build_config_switch() configure the template into
+// <name>/build_config.h, which holds the version, build type, instruction
+// set level, cache line size and the project's switches as constexpr values
+// in the <cpp_namespace>::build_config namespace.
+auto WriteBuildConfig(const std::filesystem::path& project_path,
+                      std::string_view name, std::string_view cpp_namespace,
+                      BlobStore* store) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_BUILD_CONFIG_MODULE_H
@@ -0,0 +1,20 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CLI_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CLI_H
+
+#include <charconv>
+#include <string_view>
+#include <system_error>
+
+namespace ci {
+
+// Parses a command line number, the whole text has to be a valid value.
+template <typename T>
+auto ParseNumber(std::string_view text, T& value) -> bool {
+  const auto* end = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+  return ec == std::errc{} && ptr == end;
+}
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CLI_H
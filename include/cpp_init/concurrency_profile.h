@@ -0,0 +1,21 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CONCURRENCY_PROFILE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CONCURRENCY_PROFILE_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "cpp_init/params.h"
+
+namespace ci {
+
+// Writes the concurrency core of a library: cache line padded SPSC and MPMC
+// ring queues, a Chase-Lev work-stealing deque and a thread pool built on it
+// (include/<name>/, src/thread_pool.cpp), stress tests for ThreadSanitizer
+// (tests/src/concurrency_tests.cpp) and throughput benchmarks
+// (bench/throughput.cpp).
+auto WriteConcurrencyProfile(const std::filesystem::path& project_path,
+                             const LibraryParams* param) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CONCURRENCY_PROFILE_H
@@ -0,0 +1,31 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CONSOLE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CONSOLE_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace ci {
+
+// Prompts and usage messages go through read(2) and write(2) on fixed
+// buffers instead of <iostream>, which keeps the stream objects and their
+// static initialization out of the startup of cpp_init.
+
+// Appends text to the stdout buffer, which is written when it is full, before
+// the next read from stdin and by FlushConsole.
+auto ConsoleWrite(std::string_view text) -> void;
+auto ConsoleWrite(std::size_t value) -> void;
+auto FlushConsole() -> void;
+
+// Writes text to stderr right away.
+auto ConsoleError(std::string_view text) -> void;
+
+// Flushes stdout and returns the next whitespace separated word on stdin, or
+// std::nullopt at the end of the input.
+auto ConsoleReadWord() -> std::optional<std::string>;
+// True once ConsoleReadWord returned std::nullopt.
+auto ConsoleInputEnded() -> bool;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_CONSOLE_H
@@ -0,0 +1,24 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_DEPS_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_DEPS_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+namespace ci {
+
+// Contents of cmake/deps_cache.cmake. It computes the prefix of the shared
+// dependency cache for the active compiler, ABI and C++ standard and adds it
+// to CMAKE_PREFIX_PATH. `cpp_init deps` uses the same script to find out where
+// to install, so both sides always agree on the prefix.
+auto DepsCacheCmake() -> std::string_view;
+
+// Entry point of `cpp_init deps`. Builds the dependencies used by the
+// generated projects from local source archives and installs them into the
+// shared cache prefix.
+auto RunDeps(const std::vector<std::string_view>& args) -> int32_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_DEPS_H
@@ -0,0 +1,23 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_FAST_STARTUP_MODULE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_FAST_STARTUP_MODULE_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "cpp_init/params.h"
+
+namespace ci {
+
+class BlobStore;
+
+// Writes cmake/fast_startup.cmake and bench/startup_latency.cpp. The CMake
+// function fast_startup() applies the compile and link options that shorten
+// process startup; startup_latency measures the exec-to-exit time of a
+// program against a budget and backs the <name>_startup_latency test.
+auto WriteFastStartupModule(const std::filesystem::path& project_path,
+                            const AppParams* param, BlobStore* store)
+    -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_FAST_STARTUP_MODULE_H
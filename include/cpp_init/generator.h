@@ -8,9 +8,13 @@
 
 namespace ci {
 
+class BlobStore;
+
+// Files that are identical in every generated project (cmake helpers, format
+// and tidy configs) are written through store when it isn't a nullptr.
 auto GenerateProject(const std::filesystem::path& working_dir,
-                     CommonParams* param, const SuperProjectParams* parent)
-    -> int32_t;
+                     CommonParams* param, const SuperProjectParams* parent,
+                     BlobStore* store = nullptr) -> int32_t;
 
 }  // namespace ci
 
@@ -0,0 +1,21 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_INSTRUMENTATION_MODULE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_INSTRUMENTATION_MODULE_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "cpp_init/params.h"
+
+namespace ci {
+
+// Writes include/<name>/instrumentation.h and src/instrumentation.cpp: scoped
+// timers on the TSC or CLOCK_MONOTONIC_RAW, perf_event_open hardware counters
+// and trace events in per-thread ring buffers that can be written as a Chrome
+// trace. The module compiles to nothing unless
+// <NAME>_ENABLE_INSTRUMENTATION is set.
+auto WriteInstrumentationModule(const std::filesystem::path& project_path,
+                                const LibraryParams* param) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_INSTRUMENTATION_MODULE_H
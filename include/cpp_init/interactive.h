@@ -14,6 +14,7 @@ auto QuestionUint8(std::string_view string) -> uint8_t;
 auto QuestionOptions(std::string_view question, const std::vector<std::string>& options) -> std::size_t;
 [[maybe_unused]] auto YesNoQuestion(std::string_view question) -> bool;
 
+// Returns no projects when the input ends before all questions are answered.
 auto CreateProjectQuestions() -> std::vector<std::unique_ptr<CommonParams>>;
 
 }
@@ -0,0 +1,110 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_LOG_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_LOG_H
+
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace ci {
+
+enum class LogLevel : uint8_t { kDebug, kInfo, kWarning, kError, kOff };
+
+enum class LogFormat : uint8_t {
+  // source: message key=value ...
+  kHuman,
+  // One JSON object per line with time, level, thread, source, message and
+  // the fields of the record.
+  kJson,
+};
+
+struct LogConfig {
+  LogLevel level{LogLevel::kInfo};
+  LogFormat format{LogFormat::kHuman};
+  // File descriptor the writer thread writes to.
+  int fd{2};
+};
+
+// Replaces the configuration. The default is read from the CPP_INIT_LOG_LEVEL
+// (debug, info, warning, error, off) and CPP_INIT_LOG_FORMAT (human, json)
+// environment variables.
+auto ConfigureLog(const LogConfig& config) -> void;
+auto CurrentLogConfig() -> LogConfig;
+auto ParseLogLevel(std::string_view text) -> std::optional<LogLevel>;
+auto ParseLogFormat(std::string_view text) -> std::optional<LogFormat>;
+
+// Writes every pending record and stops the writer thread. Records logged
+// afterwards are written directly. Also runs at exit.
+auto FlushLog() -> void;
+
+// A log record that is built with operator<< and Field and submitted when it
+// goes out of scope. The source must be a string literal:
+//
+//   Log(LogLevel::kError, "WriteTextFile") << "failed to open " << path;
+//
+// The record is queued in a lock-free buffer of the calling thread and
+// formatted and written by a single background thread, so logging from many
+// generator threads neither contends on a lock nor makes a system call per
+// record.
+class LogRecord {
+ public:
+  LogRecord(LogLevel level, std::string_view source);
+  ~LogRecord();
+  LogRecord(const LogRecord&) = delete;
+  auto operator=(const LogRecord&) -> LogRecord& = delete;
+
+  auto operator<<(std::string_view text) -> LogRecord&;
+  auto operator<<(const char* text) -> LogRecord&;
+  auto operator<<(const std::string& text) -> LogRecord&;
+  auto operator<<(char c) -> LogRecord&;
+  auto operator<<(const std::filesystem::path& path) -> LogRecord&;
+  template <typename T,
+            typename = std::enable_if_t<std::is_integral_v<T> &&
+                                        !std::is_same_v<T, char> &&
+                                        !std::is_same_v<T, bool>>>
+  auto operator<<(T value) -> LogRecord& {
+    if (enabled_) {
+      AppendNumber(data_.message, value);
+    }
+    return *this;
+  }
+
+  // Adds a structured key/value pair; keys must be string literals.
+  auto Field(std::string_view key, std::string_view value) -> LogRecord&;
+  auto Field(std::string_view key, int64_t value) -> LogRecord&;
+
+  // Part of the record passed to the writer thread.
+  struct Data {
+    LogLevel level{LogLevel::kInfo};
+    std::string_view source;
+    std::string message;
+    // Key, value and whether the value is a number.
+    std::vector<std::tuple<std::string_view, std::string, bool>> fields;
+  };
+
+ private:
+  template <typename T>
+  static auto AppendNumber(std::string& out, T value) -> void {
+    char buffer[24];
+    const auto [end, ec] =
+        std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, static_cast<std::size_t>(end - buffer));
+  }
+
+  bool enabled_;
+  Data data_;
+};
+
+inline auto Log(LogLevel level, std::string_view source) -> LogRecord {
+  return LogRecord{level, source};
+}
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_LOG_H
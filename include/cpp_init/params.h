@@ -1,10 +1,38 @@
 #ifndef CXX_PROJECT_CREATOR_INCLUDE_CXX_PROJECT_CREATOR_PARAMS_H
 #define CXX_PROJECT_CREATOR_INCLUDE_CXX_PROJECT_CREATOR_PARAMS_H
 
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace ci {
 
+// Orders CXX_STANDARD values, in which 98 precedes 11.
+inline auto IsOlderCppStandard(uint8_t lhs, uint8_t rhs) -> bool {
+  const auto rank = [](uint8_t standard) -> int {
+    return standard == 98 ? 0 : standard;
+  };
+  return rank(lhs) < rank(rhs);
+}
+
+// Starting point of the sources generated for an application.
+enum class AppProfile : uint8_t {
+  // An empty main().
+  kEmpty,
+  // A networked service built around an io_uring/epoll event loop.
+  kService,
+};
+
+// Starting point of the sources generated for a library.
+enum class LibraryProfile : uint8_t {
+  // Only the project structure.
+  kEmpty,
+  // Lock-free queues, a work-stealing deque and a thread pool, see
+  // WriteConcurrencyProfile.
+  kConcurrency,
+};
+
 class CommonParams {
  public:
   virtual ~CommonParams() = default;
@@ -12,10 +40,23 @@ class CommonParams {
   virtual auto IsLibrary() const -> bool { return false; }
   virtual auto IsApplication() const -> bool { return false; }
   virtual auto IsSuper() const -> bool { return false; }
+  // Oldest C++ standard the generated sources of the selected features
+  // compile with, 0 when there is no such requirement.
+  virtual auto RequiredCppStandard() const -> uint8_t {
+    return build_config ? 17 : 0;
+  }
 
   std::string name;
   uint8_t cpp_standard{0};
   bool has_parent{false};
+  // Adds build_config.h.in with constexpr build settings, see
+  // WriteBuildConfig.
+  bool build_config{false};
+  // Additional files, relative to the project directory, and link
+  // dependencies listed in the generated CMakeLists.txt.
+  std::vector<std::string> sources;
+  std::vector<std::string> headers;
+  std::vector<std::string> libraries;
 };
 
 class SuperProjectParams : public CommonParams {
@@ -29,6 +70,11 @@ class SuperProjectParams : public CommonParams {
     }
     param->has_parent = true;
     sub_projects.push_back(param->name);
+    // The dependency cache of the super project is built for the newest
+    // standard used by its sub projects.
+    cpp_standard = std::max({cpp_standard, param->cpp_standard,
+                             param->RequiredCppStandard()},
+                            IsOlderCppStandard);
   }
 
   std::vector<std::string> sub_projects;
@@ -39,10 +85,25 @@ class LibraryParams : public CommonParams {
   ~LibraryParams() override = default;
 
   auto IsLibrary() const -> bool { return true; }
+  auto RequiredCppStandard() const -> uint8_t override {
+    if (profile == LibraryProfile::kConcurrency || instrumentation) {
+      return 17;
+    }
+    return CommonParams::RequiredCppStandard();
+  }
 
   std::string cmake_namespace;
   std::string cpp_namespace;
   std::string alias;
+  LibraryProfile profile{LibraryProfile::kEmpty};
+  // Adds include/<name>/instrumentation.h, see WriteInstrumentationModule.
+  bool instrumentation{false};
+  // Adds the *_fwd.h/*.h/*_impl.h header firewall with explicit template
+  // instantiations, see WriteTemplateScaffolding.
+  bool explicit_instantiation{false};
+  // Compiles the sources once into the <name>_objects OBJECT library, which
+  // is consumed by the library, its shared variant and the tests.
+  bool object_library{false};
 };
 
 class AppParams : public CommonParams {
@@ -50,12 +111,42 @@ class AppParams : public CommonParams {
   ~AppParams() override = default;
 
   auto IsApplication() const -> bool { return true; }
+  auto RequiredCppStandard() const -> uint8_t override {
+    if (embed_resources) {
+      return 20;
+    }
+    if (profile == AppProfile::kService || allocator_selection) {
+      return 17;
+    }
+    return CommonParams::RequiredCppStandard();
+  }
 
   std::string cmake_namespace;
   std::string cpp_namespace;
   std::string output_name;
+  AppProfile profile{AppProfile::kEmpty};
+  // Adds the <NAME>_ALLOCATOR cache variable, allocator statistics and an
+  // allocation benchmark, see WriteAllocatorModule.
+  bool allocator_selection{false};
+  // Compiles the files in resources/ into the executable, see
+  // WriteResourceModule.
+  bool embed_resources{false};
+  // Applies the fast-startup link profile and adds a startup latency test,
+  // see WriteFastStartupModule.
+  bool fast_startup{false};
 };
 
+// Raises cpp_standard to RequiredCppStandard(), returns true when it was
+// older.
+inline auto RaiseCppStandard(CommonParams* param) -> bool {
+  const auto required = param->RequiredCppStandard();
+  if (!IsOlderCppStandard(param->cpp_standard, required)) {
+    return false;
+  }
+  param->cpp_standard = required;
+  return true;
+}
+
 }  // namespace ci
 
 #endif  // CXX_PROJECT_CREATOR_INCLUDE_CXX_PROJECT_CREATOR_PARAMS_H
@@ -0,0 +1,23 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_RESOURCE_MODULE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_RESOURCE_MODULE_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "cpp_init/params.h"
+
+namespace ci {
+
+class BlobStore;
+
+// Writes resources/, cmake/resources.cmake and the templates of the
+// generated <name>/resources.h and resources.cpp. embed_resources() compiles
+// the files in resources/ into the application with #embed, an assembler
+// .incbin directive or a generated byte array, whichever the toolchain
+// supports, and indexes them by a constexpr ResourceId.
+auto WriteResourceModule(const std::filesystem::path& project_path,
+                         const AppParams* param, BlobStore* store) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_RESOURCE_MODULE_H
@@ -0,0 +1,20 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_SERVICE_PROFILE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_SERVICE_PROFILE_H
+
+#include <cstdint>
+#include <filesystem>
+
+#include "cpp_init/params.h"
+
+namespace ci {
+
+// Writes the sources of a networked service: a thread-per-core echo server
+// with an io_uring event loop (epoll when io_uring is unavailable), lock-free
+// handoff of accepted connections, signalfd based graceful shutdown and a
+// loopback load generator in bench/.
+auto WriteServiceProfile(const std::filesystem::path& project_path,
+                         const AppParams* param) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_SERVICE_PROFILE_H
@@ -0,0 +1,18 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_SYNTH_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_SYNTH_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace ci {
+
+// Entry point of `cpp_init synth`. Generates a super project with synthetic
+// libraries and applications that depend on each other in layers, to measure
+// how configure, build and link times scale. The same options and seed always
+// produce the same tree.
+auto RunSynth(const std::vector<std::string_view>& args) -> int32_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_SYNTH_H
@@ -0,0 +1,26 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_TEMPLATE_SCAFFOLDING_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_TEMPLATE_SCAFFOLDING_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+
+#include "cpp_init/params.h"
+
+namespace ci {
+
+// Standard headers that public headers of a scaffolded library may include.
+auto PublicHeaderAllowlist() -> std::vector<std::string_view>;
+
+// Writes a header firewall for template heavy libraries: <name>_fwd.h with
+// forward declarations, <name>.h with declarations and extern template
+// declarations, <name>_impl.h with the definitions, src/instantiations.cpp
+// with the explicit instantiations and cmake/public_header_check.cmake, which
+// rejects public headers that include headers outside the allowlist.
+auto WriteTemplateScaffolding(const std::filesystem::path& project_path,
+                              const LibraryParams* param) -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_TEMPLATE_SCAFFOLDING_H
@@ -0,0 +1,35 @@
+#ifndef CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_TEXT_FILE_H
+#define CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_TEXT_FILE_H
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace ci {
+
+using Substitutions = std::vector<std::pair<std::string_view, std::string>>;
+
+// Replaces every @KEY@ in text by the value of KEY, similar to CMake's
+// configure_file(@ONLY). Unknown keys are left untouched.
+auto Substitute(std::string_view text, const Substitutions& substitutions)
+    -> std::string;
+
+// Upper case identifier usable in macros and CMake variables: letters are
+// converted to upper case and every other non alphanumeric character to '_'.
+auto ToUpperIdentifier(std::string_view name) -> std::string;
+
+// Substitutions shared by the project templates: NAME, NS (C++ namespace),
+// UPPER (ToUpperIdentifier of the name) and GUARD (include guard prefix).
+auto ProjectSubstitutions(std::string_view name, std::string_view cpp_namespace)
+    -> Substitutions;
+
+// Writes content to path, the parent directory must exist.
+auto WriteTextFile(const std::filesystem::path& path, std::string_view content)
+    -> uint8_t;
+
+}  // namespace ci
+
+#endif  // CXX_PROJECT_CREATOR_INCLUDE_CPP_INIT_TEXT_FILE_H
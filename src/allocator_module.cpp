@@ -0,0 +1,409 @@
+#include "cpp_init/allocator_module.h"
+
+#include <string_view>
+#include <utility>
+
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+constexpr std::string_view kAllocatorCmake{R"tmpl(# Memory allocator of @NAME@. The allocator is linked through the
+# @NAME@_allocator interface target, which also defines
+# @UPPER@_ALLOCATOR_<NAME> so the code can print the statistics of the
+# selected allocator.
+set(@UPPER@_ALLOCATOR "system" CACHE STRING
+        "Memory allocator: system, jemalloc, mimalloc or tcmalloc")
+set_property(CACHE @UPPER@_ALLOCATOR
+        PROPERTY STRINGS system jemalloc mimalloc tcmalloc)
+option(@UPPER@_ALLOCATOR_STATS "Print allocator statistics on exit" OFF)
+
+add_library(@NAME@_allocator INTERFACE)
+string(TOUPPER "${@UPPER@_ALLOCATOR}" _@NAME@_allocator)
+target_compile_definitions(@NAME@_allocator INTERFACE
+        @UPPER@_ALLOCATOR_${_@NAME@_allocator}
+        @UPPER@_ALLOCATOR_STATS=$<BOOL:${@UPPER@_ALLOCATOR_STATS}>)
+
+# Finds library and header of an allocator without a CMake package, first
+# through pkg-config and then in the default search paths.
+macro(_@NAME@_find_allocator prefix pkg_name header)
+    find_package(PkgConfig QUIET)
+    if (PkgConfig_FOUND)
+        pkg_check_modules(${prefix} QUIET IMPORTED_TARGET ${pkg_name})
+    endif ()
+    if (${prefix}_FOUND)
+        target_link_libraries(@NAME@_allocator INTERFACE PkgConfig::${prefix})
+    else ()
+        find_library(${prefix}_LIBRARY NAMES ${ARGN})
+        find_path(${prefix}_INCLUDE_DIR ${header})
+        if (NOT ${prefix}_LIBRARY OR NOT ${prefix}_INCLUDE_DIR)
+            message(FATAL_ERROR "@UPPER@_ALLOCATOR is ${@UPPER@_ALLOCATOR}, "
+                    "but ${header} or the library wasn't found. Install it, "
+                    "add its prefix to CMAKE_PREFIX_PATH or set "
+                    "@UPPER@_ALLOCATOR to system.")
+        endif ()
+        target_include_directories(@NAME@_allocator INTERFACE
+                ${${prefix}_INCLUDE_DIR})
+        target_link_libraries(@NAME@_allocator INTERFACE ${${prefix}_LIBRARY})
+    endif ()
+endmacro()
+
+if (@UPPER@_ALLOCATOR STREQUAL "jemalloc")
+    _@NAME@_find_allocator(@UPPER@_JEMALLOC jemalloc jemalloc/jemalloc.h
+            jemalloc)
+elseif (@UPPER@_ALLOCATOR STREQUAL "mimalloc")
+    find_package(mimalloc CONFIG QUIET)
+    if (TARGET mimalloc)
+        target_link_libraries(@NAME@_allocator INTERFACE mimalloc)
+    elseif (TARGET mimalloc-static)
+        target_link_libraries(@NAME@_allocator INTERFACE mimalloc-static)
+    else ()
+        _@NAME@_find_allocator(@UPPER@_MIMALLOC mimalloc mimalloc.h mimalloc)
+    endif ()
+elseif (@UPPER@_ALLOCATOR STREQUAL "tcmalloc")
+    _@NAME@_find_allocator(@UPPER@_TCMALLOC libtcmalloc
+            gperftools/malloc_extension_c.h tcmalloc tcmalloc_minimal)
+elseif (NOT @UPPER@_ALLOCATOR STREQUAL "system")
+    message(FATAL_ERROR "Unknown @UPPER@_ALLOCATOR: ${@UPPER@_ALLOCATOR}")
+endif ()
+
+if (NOT @UPPER@_ALLOCATOR STREQUAL "system"
+        AND CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang")
+    # Calls to malloc and free must reach the replacement allocator.
+    target_compile_options(@NAME@_allocator INTERFACE
+            -fno-builtin-malloc -fno-builtin-calloc -fno-builtin-realloc
+            -fno-builtin-free)
+endif ()
+message(STATUS "@NAME@ allocator: ${@UPPER@_ALLOCATOR}")
+)tmpl"};
+
+constexpr std::string_view kAllocatorStatsHeader{R"tmpl(#ifndef @GUARD@_ALLOCATOR_STATS_H
+#define @GUARD@_ALLOCATOR_STATS_H
+
+#include <cstdio>
+
+namespace @NS@ {
+namespace allocator {
+
+// Name of the allocator selected with the @UPPER@_ALLOCATOR CMake variable.
+auto Name() -> const char*;
+
+// Writes the statistics of the allocator to out in its native format.
+auto DumpStats(std::FILE* out) -> void;
+
+// Dumps the statistics to stderr when the process exits, if
+// @UPPER@_ALLOCATOR_STATS is enabled. Call it at the start of main().
+auto DumpStatsAtExit() -> void;
+
+}  // namespace allocator
+}  // namespace @NS@
+
+#endif  // @GUARD@_ALLOCATOR_STATS_H
+)tmpl"};
+
+constexpr std::string_view kAllocatorStatsSource{R"tmpl(#include "@NAME@/allocator_stats.h"
+
+#include <cstdlib>
+
+#if defined(@UPPER@_ALLOCATOR_JEMALLOC)
+#include <jemalloc/jemalloc.h>
+#elif defined(@UPPER@_ALLOCATOR_MIMALLOC)
+#include <mimalloc.h>
+#elif defined(@UPPER@_ALLOCATOR_TCMALLOC)
+#include <gperftools/malloc_extension_c.h>
+#elif defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace @NS@ {
+namespace allocator {
+namespace {
+
+[[maybe_unused]] auto Print(void* out, const char* text) -> void {
+  std::fputs(text, static_cast<std::FILE*>(out));
+}
+
+}  // namespace
+
+auto Name() -> const char* {
+#if defined(@UPPER@_ALLOCATOR_JEMALLOC)
+  return "jemalloc";
+#elif defined(@UPPER@_ALLOCATOR_MIMALLOC)
+  return "mimalloc";
+#elif defined(@UPPER@_ALLOCATOR_TCMALLOC)
+  return "tcmalloc";
+#else
+  return "system";
+#endif
+}
+
+auto DumpStats(std::FILE* out) -> void {
+  std::fprintf(out, "allocator: %s\n", Name());
+#if defined(@UPPER@_ALLOCATOR_JEMALLOC)
+  malloc_stats_print(Print, out, nullptr);
+#elif defined(@UPPER@_ALLOCATOR_MIMALLOC)
+  mi_stats_print_out([](const char* text, void* arg) { Print(arg, text); },
+                     out);
+#elif defined(@UPPER@_ALLOCATOR_TCMALLOC)
+  static char buffer[1 << 16];
+  MallocExtension_GetStats(buffer, sizeof(buffer));
+  std::fputs(buffer, out);
+#elif defined(__GLIBC__)
+  malloc_info(0, out);
+#endif
+  std::fflush(out);
+}
+
+auto DumpStatsAtExit() -> void {
+#if defined(@UPPER@_ALLOCATOR_STATS) && @UPPER@_ALLOCATOR_STATS
+  std::atexit([] { DumpStats(stderr); });
+#endif
+}
+
+}  // namespace allocator
+}  // namespace @NS@
+)tmpl"};
+
+constexpr std::string_view kAllocBenchSource{R"tmpl(// Allocation-heavy microbenchmark for comparing the allocators selectable with
+// @UPPER@_ALLOCATOR. Reconfigure with another allocator and run it again on
+// the target hardware:
+//
+//   cmake -B build -D@UPPER@_ALLOCATOR=jemalloc && cmake --build build
+//   build/@NAME@_alloc_bench --threads 8
+//
+// Two workloads run on every thread:
+//   local:  random sized allocations replacing a random slot of a working set
+//           owned by the thread.
+//   remote: batches allocated by one thread and freed by the next one, the
+//           producer/consumer pattern of most services.
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "@NAME@/allocator_stats.h"
+
+namespace {
+
+struct Options {
+  unsigned threads{std::max(1U, std::thread::hardware_concurrency())};
+  uint64_t operations{2000000};
+  std::size_t max_size{4096};
+  std::size_t working_set{4096};
+  std::size_t batch{256};
+};
+
+template <typename T>
+auto Parse(std::string_view text, T& value) -> bool {
+  const auto* end = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+  return ec == std::errc{} && ptr == end;
+}
+
+class Random {
+ public:
+  explicit Random(uint64_t seed) : state_{seed * 0x9E3779B97F4A7C15ULL + 1} {}
+
+  auto Next() -> uint64_t {
+    state_ ^= state_ << 13U;
+    state_ ^= state_ >> 7U;
+    state_ ^= state_ << 17U;
+    return state_;
+  }
+
+  // Small sizes are much more frequent than large ones, like in most programs.
+  auto Size(std::size_t max_size) -> std::size_t {
+    const auto bits = Next();
+    const auto limit = std::size_t{16} << (bits % 9U);
+    return 1 + (bits >> 8U) % std::min(limit, max_size);
+  }
+
+ private:
+  uint64_t state_;
+};
+
+auto Touch(void* pointer, std::size_t size) -> void {
+  static_cast<char*>(pointer)[0] = 1;
+  static_cast<char*>(pointer)[size - 1] = 1;
+}
+
+auto Local(const Options& options, unsigned thread) -> void {
+  Random random{thread};
+  std::vector<std::pair<void*, std::size_t>> slots(options.working_set);
+  for (uint64_t i{0}; i < options.operations; ++i) {
+    auto& [pointer, size] = slots[random.Next() % slots.size()];
+    std::free(pointer);
+    size = random.Size(options.max_size);
+    pointer = std::malloc(size);
+    Touch(pointer, size);
+  }
+  for (auto& slot : slots) {
+    std::free(slot.first);
+  }
+}
+
+// Hands batches of allocations from one thread to the next.
+class Mailbox {
+ public:
+  auto Put(std::vector<void*> batch) -> void {
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      batches_.push_back(std::move(batch));
+    }
+    ready_.notify_one();
+  }
+
+  auto Take() -> std::vector<void*> {
+    std::unique_lock<std::mutex> lock{mutex_};
+    ready_.wait(lock, [this] { return !batches_.empty(); });
+    auto batch = std::move(batches_.back());
+    batches_.pop_back();
+    return batch;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::vector<std::vector<void*>> batches_;
+};
+
+auto Remote(const Options& options, unsigned thread,
+            std::vector<Mailbox>& mailboxes) -> void {
+  Random random{thread + 1000U};
+  const auto rounds = options.operations / options.batch;
+  auto& next = mailboxes[(thread + 1) % mailboxes.size()];
+  for (uint64_t round{0}; round < rounds; ++round) {
+    std::vector<void*> batch;
+    batch.reserve(options.batch);
+    for (std::size_t i{0}; i < options.batch; ++i) {
+      const auto size = random.Size(options.max_size);
+      batch.push_back(std::malloc(size));
+      Touch(batch.back(), size);
+    }
+    next.Put(std::move(batch));
+    for (auto* pointer : mailboxes[thread].Take()) {
+      std::free(pointer);
+    }
+  }
+}
+
+template <typename Workload>
+auto Run(const char* name, const Options& options, Workload workload) -> void {
+  std::vector<std::thread> threads;
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned t{0}; t < options.threads; ++t) {
+    threads.emplace_back(workload, t);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() -
+                                              start};
+  const auto operations = static_cast<double>(options.operations) *
+                          static_cast<double>(options.threads);
+  std::printf("%-8s %10.2f Mops/s %8.1f ns/op (%u threads)\n", name,
+              operations / elapsed.count() / 1e6,
+              elapsed.count() * 1e9 * options.threads / operations,
+              options.threads);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i{1}; i < argc; i += 2) {
+    const std::string_view key{argv[i]};
+    const std::string_view value{i + 1 < argc ? argv[i + 1] : ""};
+    bool ok{false};
+    if (key == "--threads") {
+      ok = Parse(value, options.threads) && options.threads > 0;
+    } else if (key == "--ops") {
+      ok = Parse(value, options.operations);
+    } else if (key == "--max-size") {
+      ok = Parse(value, options.max_size) && options.max_size > 0;
+    }
+    if (!ok) {
+      std::fprintf(stderr,
+                   "usage: %s [--threads N] [--ops N] [--max-size BYTES]\n",
+                   argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::printf("allocator: %s\n", @NS@::allocator::Name());
+  Run("local", options,
+      [&options](unsigned thread) { Local(options, thread); });
+  std::vector<Mailbox> mailboxes(options.threads);
+  Run("remote", options, [&options, &mailboxes](unsigned thread) {
+    Remote(options, thread, mailboxes);
+  });
+
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  std::printf("max rss: %ld KiB\n", usage.ru_maxrss);
+  if (std::getenv("@UPPER@_ALLOC_BENCH_STATS") != nullptr) {
+    @NS@::allocator::DumpStats(stdout);
+  }
+  return EXIT_SUCCESS;
+}
+)tmpl"};
+
+}  // namespace
+
+auto WriteAllocatorModule(const std::filesystem::path& project_path,
+                          const AppParams* param) -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteAllocatorModule")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteAllocatorModule") << "param is a nullptr";
+    return 2;
+  }
+  const auto cmake_path = project_path / "cmake";
+  const auto bench_path = project_path / "bench";
+  for (const auto& dir : {cmake_path, bench_path}) {
+    std::error_code error_code;
+    std::filesystem::create_directories(dir, error_code);
+    if (error_code) {
+      Log(LogLevel::kError, "WriteAllocatorModule")
+          .Field("errno", error_code.value())
+          .Field("error", error_code.message())
+          << "failed to create directory: " << dir;
+      return 3;
+    }
+  }
+
+  const auto substitutions =
+      ProjectSubstitutions(param->name, param->cpp_namespace);
+  const std::pair<std::filesystem::path, std::string_view> files[]{
+      {cmake_path / "allocator.cmake", kAllocatorCmake},
+      {project_path / "include" / param->name / "allocator_stats.h",
+       kAllocatorStatsHeader},
+      {project_path / "src" / "allocator_stats.cpp", kAllocatorStatsSource},
+      {bench_path / "alloc_bench.cpp", kAllocBenchSource},
+  };
+  for (const auto& [path, text] : files) {
+    if (WriteTextFile(path, Substitute(text, substitutions)) != 0) {
+      Log(LogLevel::kError, "WriteAllocatorModule") << "failed to write "
+                                                    << path;
+      return 4;
+    }
+  }
+  return 0;
+}
+
+}  // namespace ci
@@ -0,0 +1,130 @@
+#include "cpp_init/blob_store.h"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/fs.h>
+#endif
+
+#include <cerrno>
+
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+enum class ReflinkResult : uint8_t { kDone, kUnsupported, kFailed };
+
+auto Reflink(const std::filesystem::path& source,
+             const std::filesystem::path& path) -> ReflinkResult {
+#if defined(FICLONE)
+  const int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in < 0) {
+    return ReflinkResult::kFailed;
+  }
+  const int out = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC,
+                       0644);
+  if (out < 0) {
+    close(in);
+    return ReflinkResult::kFailed;
+  }
+  const int rv = ioctl(out, FICLONE, in);
+  const int error = errno;
+  close(out);
+  close(in);
+  if (rv == 0) {
+    return ReflinkResult::kDone;
+  }
+  // EXDEV (other file system) and EINVAL (unaligned or special file) may be
+  // specific to this pair of files, the others hold for the file system.
+  if (error == EOPNOTSUPP || error == ENOTTY || error == ENOSYS) {
+    return ReflinkResult::kUnsupported;
+  }
+  return ReflinkResult::kFailed;
+#else
+  static_cast<void>(source);
+  static_cast<void>(path);
+  return ReflinkResult::kUnsupported;
+#endif
+}
+
+}  // namespace
+
+auto BlobStore::Write(const std::filesystem::path& path,
+                      std::string_view content) -> uint8_t {
+  std::filesystem::path source;
+  {
+    // The first copy is written while holding the lock, so other threads only
+    // link to complete files.
+    const std::lock_guard<std::mutex> lock{mutex_};
+    auto [it, inserted] = blobs_.try_emplace(std::string{content});
+    if (inserted) {
+      if (const auto rv = WriteTextFile(path, content); rv != 0) {
+        blobs_.erase(it);
+        return rv;
+      }
+      it->second = path;
+      ++stats_.files;
+      ++stats_.blobs;
+      stats_.bytes_written += content.size();
+      return 0;
+    }
+    source = it->second;
+  }
+  return Place(source, path, content);
+}
+
+auto BlobStore::Place(const std::filesystem::path& source,
+                      const std::filesystem::path& path,
+                      std::string_view content) -> uint8_t {
+  if (mode_ == LinkMode::kReflink && reflink_supported_.load()) {
+    const auto result = Reflink(source, path);
+    if (result == ReflinkResult::kDone) {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      ++stats_.files;
+      ++stats_.reflinks;
+      stats_.bytes_saved += content.size();
+      return 0;
+    }
+    if (result == ReflinkResult::kUnsupported) {
+      reflink_supported_.store(false);
+    }
+  }
+  if (mode_ == LinkMode::kHardlink) {
+    std::error_code error_code;
+    std::filesystem::remove(path, error_code);
+    std::filesystem::create_hard_link(source, path, error_code);
+    if (!error_code) {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      ++stats_.files;
+      ++stats_.hardlinks;
+      stats_.bytes_saved += content.size();
+      return 0;
+    }
+  }
+  if (const auto rv = WriteTextFile(path, content); rv != 0) {
+    return rv;
+  }
+  const std::lock_guard<std::mutex> lock{mutex_};
+  ++stats_.files;
+  ++stats_.copies;
+  stats_.bytes_written += content.size();
+  return 0;
+}
+
+auto BlobStore::Stats() const -> BlobStoreStats {
+  const std::lock_guard<std::mutex> lock{mutex_};
+  return stats_;
+}
+
+auto WriteSharedFile(const std::filesystem::path& path,
+                     std::string_view content, BlobStore* store) -> uint8_t {
+  if (store != nullptr) {
+    return store->Write(path, content);
+  }
+  return WriteTextFile(path, content);
+}
+
+}  // namespace ci
@@ -0,0 +1,246 @@
+#include "cpp_init/build_config_module.h"
+
+#include <string_view>
+
+#include "cpp_init/blob_store.h"
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+// @NAME@, @NS@ and @GUARD@ are replaced by cpp_init, the BUILD_CONFIG_*
+// variables by configure_file() and the generator expressions by
+// file(GENERATE), once per configuration.
+constexpr std::string_view kBuildConfigHeader{R"tmpl(#ifndef @GUARD@_BUILD_CONFIG_H
+#define @GUARD@_BUILD_CONFIG_H
+
+// Generated from build_config.h.in by build_config() in
+// cmake/build_config.cmake. Every value is a constant expression, so hot
+// paths can pick an implementation with if constexpr or a template
+// specialization instead of testing a flag at runtime.
+
+#include <cstddef>
+#include <string_view>
+
+namespace @NS@::build_config {
+
+inline constexpr std::string_view kProjectName{"@NAME@"};
+inline constexpr std::string_view kVersion{"@BUILD_CONFIG_VERSION@"};
+inline constexpr unsigned kVersionMajor{@BUILD_CONFIG_VERSION_MAJOR@};
+inline constexpr unsigned kVersionMinor{@BUILD_CONFIG_VERSION_MINOR@};
+inline constexpr unsigned kVersionPatch{@BUILD_CONFIG_VERSION_PATCH@};
+
+// CMAKE_BUILD_TYPE, or the configuration of a multi-config generator.
+inline constexpr std::string_view kBuildType{"$<CONFIG>"};
+inline constexpr bool kDebug{$<IF:$<CONFIG:Debug>,true,false>};
+
+// The BUILD_CONFIG_CACHE_LINE_SIZE cache variable, detected on the build
+// machine when it is configured the first time.
+inline constexpr std::size_t kCacheLineSize{@BUILD_CONFIG_CACHE_LINE_SIZE@};
+
+// Instruction set level of the translation unit, derived from the macros
+// the compiler predefines for -march=, -mavx2 and so on. Levels of different
+// architectures don't compare meaningfully.
+enum class IsaLevel : unsigned {
+  kBaseline,
+  kX86_64V2,
+  kX86_64V3,
+  kX86_64V4,
+  kNeon,
+  kSve,
+};
+
+inline constexpr IsaLevel kIsaLevel{
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512CD__) && \
+    defined(__AVX512DQ__) && defined(__AVX512VL__)
+    IsaLevel::kX86_64V4
+#elif defined(__AVX2__) && defined(__BMI2__) && defined(__FMA__)
+    IsaLevel::kX86_64V3
+#elif defined(__SSE4_2__) && defined(__POPCNT__)
+    IsaLevel::kX86_64V2
+#elif defined(__ARM_FEATURE_SVE)
+    IsaLevel::kSve
+#elif defined(__ARM_NEON)
+    IsaLevel::kNeon
+#else
+    IsaLevel::kBaseline
+#endif
+};
+
+inline constexpr bool kHasSse42{
+#ifdef __SSE4_2__
+    true
+#else
+    false
+#endif
+};
+
+inline constexpr bool kHasAvx2{
+#ifdef __AVX2__
+    true
+#else
+    false
+#endif
+};
+
+inline constexpr bool kHasAvx512{
+#ifdef __AVX512F__
+    true
+#else
+    false
+#endif
+};
+
+inline constexpr bool kHasNeon{
+#ifdef __ARM_NEON
+    true
+#else
+    false
+#endif
+};
+
+// Switches added with build_config_switch().
+@BUILD_CONFIG_SWITCHES@
+}  // namespace @NS@::build_config
+
+#endif  // @GUARD@_BUILD_CONFIG_H
+)tmpl"};
+
+constexpr std::string_view kBuildConfigCmake{R"cmake(# Generates <name>/build_config.h from build_config.h.in in the current source
+# directory.
+#
+#   build_config(<name> <target>...)
+#     Adds the directory of the generated header to the include path of the
+#     targets. The header is written when the directory has been processed,
+#     so switches may be added after this call.
+#
+#   build_config_switch(<name> <SWITCH> <value>)
+#     Adds `inline constexpr bool k<Switch>{true|false};` to the header;
+#     <value> is true unless it is empty or a false constant such as OFF:
+#
+#       option(MYLIB_FAST_PATH "Use the fast path" ON)
+#       build_config_switch(mylib FAST_PATH ${MYLIB_FAST_PATH})
+#
+# BUILD_CONFIG_CACHE_LINE_SIZE holds the cache line size of the build machine;
+# set it explicitly when cross compiling.
+
+include_guard(GLOBAL)
+
+if (NOT DEFINED BUILD_CONFIG_CACHE_LINE_SIZE)
+    set(_build_config_cache_line_size 64)
+    set(_build_config_sysfs
+        "/sys/devices/system/cpu/cpu0/cache/index0/coherency_line_size")
+    if (NOT CMAKE_CROSSCOMPILING AND EXISTS "${_build_config_sysfs}")
+        file(READ "${_build_config_sysfs}" _build_config_cache_line_size)
+        string(STRIP "${_build_config_cache_line_size}"
+               _build_config_cache_line_size)
+    elseif (NOT CMAKE_CROSSCOMPILING AND APPLE)
+        execute_process(COMMAND sysctl -n hw.cachelinesize
+                        OUTPUT_VARIABLE _build_config_cache_line_size
+                        OUTPUT_STRIP_TRAILING_WHITESPACE
+                        ERROR_QUIET)
+    endif ()
+    if (NOT _build_config_cache_line_size MATCHES "^[1-9][0-9]*$")
+        set(_build_config_cache_line_size 64)
+    endif ()
+    set(BUILD_CONFIG_CACHE_LINE_SIZE ${_build_config_cache_line_size}
+        CACHE STRING "Cache line size in bytes written to build_config.h")
+endif ()
+
+function(build_config name)
+    set(_dir "${CMAKE_CURRENT_BINARY_DIR}/build_config/$<CONFIG>")
+    foreach (_target IN LISTS ARGN)
+        target_include_directories(${_target} PUBLIC
+                                   "$<BUILD_INTERFACE:${_dir}>")
+    endforeach ()
+    # Evaluates ${name} now; arguments of deferred calls are evaluated when
+    # the call runs.
+    cmake_language(EVAL CODE
+        "cmake_language(DEFER CALL _build_config_generate [[${name}]])")
+endfunction()
+
+function(build_config_switch name switch)
+    string(TOLOWER "${switch}" _words)
+    string(REPLACE "_" ";" _words "${_words}")
+    set(_constant k)
+    foreach (_word IN LISTS _words)
+        string(SUBSTRING "${_word}" 0 1 _first)
+        string(SUBSTRING "${_word}" 1 -1 _rest)
+        string(TOUPPER "${_first}" _first)
+        string(APPEND _constant "${_first}${_rest}")
+    endforeach ()
+    set(_value "${ARGN}")
+    if (_value)
+        set(_value true)
+    else ()
+        set(_value false)
+    endif ()
+    set_property(GLOBAL APPEND PROPERTY _build_config_${name}_switches
+                 "${_constant}{${_value}}")
+endfunction()
+
+function(_build_config_generate name)
+    set(BUILD_CONFIG_VERSION "${PROJECT_VERSION}")
+    foreach (_part MAJOR MINOR PATCH)
+        set(BUILD_CONFIG_VERSION_${_part} "${PROJECT_VERSION_${_part}}")
+        if (NOT BUILD_CONFIG_VERSION_${_part} MATCHES "^[0-9]+$")
+            set(BUILD_CONFIG_VERSION_${_part} 0)
+        endif ()
+    endforeach ()
+    get_property(_switches GLOBAL PROPERTY _build_config_${name}_switches)
+    set(BUILD_CONFIG_SWITCHES "")
+    foreach (_switch IN LISTS _switches)
+        string(APPEND BUILD_CONFIG_SWITCHES
+               "inline constexpr bool ${_switch};\n")
+    endforeach ()
+    set(_configured "${CMAKE_CURRENT_BINARY_DIR}/build_config/build_config.h.in")
+    configure_file("${CMAKE_CURRENT_SOURCE_DIR}/build_config.h.in"
+                   "${_configured}" @ONLY)
+    file(GENERATE
+         OUTPUT
+             "${CMAKE_CURRENT_BINARY_DIR}/build_config/$<CONFIG>/${name}/build_config.h"
+         INPUT "${_configured}")
+endfunction()
+)cmake"};
+
+}  // namespace
+
+auto WriteBuildConfig(const std::filesystem::path& project_path,
+                      std::string_view name, std::string_view cpp_namespace,
+                      BlobStore* store) -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteBuildConfig")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  const auto cmake_path = project_path / "cmake";
+  std::error_code error_code;
+  std::filesystem::create_directories(cmake_path, error_code);
+  if (error_code) {
+    Log(LogLevel::kError, "WriteBuildConfig")
+        .Field("errno", error_code.value())
+        .Field("error", error_code.message())
+        << "failed to create directory: " << cmake_path;
+    return 2;
+  }
+
+  const auto header_path = project_path / "build_config.h.in";
+  if (WriteTextFile(header_path,
+                    Substitute(kBuildConfigHeader,
+                               ProjectSubstitutions(name, cpp_namespace))) !=
+      0) {
+    Log(LogLevel::kError, "WriteBuildConfig") << "failed to write "
+                                              << header_path;
+    return 3;
+  }
+  const auto cmake_file = cmake_path / "build_config.cmake";
+  if (WriteSharedFile(cmake_file, kBuildConfigCmake, store) != 0) {
+    Log(LogLevel::kError, "WriteBuildConfig") << "failed to write "
+                                              << cmake_file;
+    return 4;
+  }
+  return 0;
+}
+
+}  // namespace ci
@@ -0,0 +1,1015 @@
+#include "cpp_init/concurrency_profile.h"
+
+#include <string_view>
+#include <utility>
+
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+constexpr std::string_view kCacheLineHeader{R"tmpl(#ifndef @GUARD@_CACHE_LINE_H
+#define @GUARD@_CACHE_LINE_H
+
+#include <cstddef>
+
+namespace @NS@ {
+
+// Alignment that keeps data written by different threads on different cache
+// lines. std::hardware_destructive_interference_size isn't used because its
+// value may differ between compilers and translation units. On x86 the
+// adjacent line prefetcher pulls pairs of lines, hence 128 bytes.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__aarch64__) || \
+    defined(__powerpc64__)
+inline constexpr std::size_t kCacheLineSize{128};
+#else
+inline constexpr std::size_t kCacheLineSize{64};
+#endif
+
+// Smallest power of two that isn't smaller than value.
+constexpr auto RoundUpToPowerOfTwo(std::size_t value) -> std::size_t {
+  std::size_t result{1};
+  while (result < value) {
+    result <<= 1U;
+  }
+  return result;
+}
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_CACHE_LINE_H
+)tmpl"};
+
+constexpr std::string_view kSpscRingHeader{R"tmpl(#ifndef @GUARD@_SPSC_RING_H
+#define @GUARD@_SPSC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "@NAME@/cache_line.h"
+
+namespace @NS@ {
+
+// Bounded single-producer single-consumer ring buffer. One thread may call
+// TryPush/TryEmplace and one other thread TryPop. The producer and consumer
+// indices live on separate cache lines, and each side caches the index of the
+// other side, so the shared lines are only read when the ring looks full or
+// empty.
+template <typename T>
+class SpscRing {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit SpscRing(std::size_t capacity)
+      : mask_{RoundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2)) - 1},
+        slots_{new Storage[mask_ + 1]} {}
+  ~SpscRing() {
+    while (TryPop()) {
+    }
+    delete[] slots_;
+  }
+  SpscRing(const SpscRing&) = delete;
+  auto operator=(const SpscRing&) -> SpscRing& = delete;
+
+  template <typename... Args>
+  auto TryEmplace(Args&&... args) -> bool {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_cache_ > mask_) {
+      head_cache_ = head_.load(std::memory_order_acquire);
+      if (tail - head_cache_ > mask_) {
+        return false;
+      }
+    }
+    new (Slot(tail)) T(std::forward<Args>(args)...);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto TryPush(T value) -> bool { return TryEmplace(std::move(value)); }
+
+  auto TryPop() -> std::optional<T> {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_cache_) {
+      tail_cache_ = tail_.load(std::memory_order_acquire);
+      if (head == tail_cache_) {
+        return std::nullopt;
+      }
+    }
+    auto* slot = Slot(head);
+    std::optional<T> value{std::move(*slot)};
+    slot->~T();
+    head_.store(head + 1, std::memory_order_release);
+    return value;
+  }
+
+  auto Capacity() const -> std::size_t { return mask_ + 1; }
+
+ private:
+  struct Storage {
+    alignas(T) unsigned char bytes[sizeof(T)];
+  };
+
+  auto Slot(std::size_t index) -> T* {
+    return std::launder(reinterpret_cast<T*>(slots_[index & mask_].bytes));
+  }
+
+  // Written by the consumer.
+  alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+  std::size_t tail_cache_{0};
+  // Written by the producer.
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+  std::size_t head_cache_{0};
+  // Read only.
+  alignas(kCacheLineSize) const std::size_t mask_;
+  Storage* const slots_;
+};
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_SPSC_RING_H
+)tmpl"};
+
+constexpr std::string_view kMpmcRingHeader{R"tmpl(#ifndef @GUARD@_MPMC_RING_H
+#define @GUARD@_MPMC_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "@NAME@/cache_line.h"
+
+namespace @NS@ {
+
+// Bounded multi-producer multi-consumer ring buffer (D. Vyukov). Every slot
+// carries a sequence number that tells producers and consumers whether the
+// slot is free for the current lap, so a push or pop is one CAS on the shared
+// index. Slots are padded to a cache line, so neighbouring producers and
+// consumers don't share lines.
+template <typename T>
+class MpmcRing {
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit MpmcRing(std::size_t capacity)
+      : mask_{RoundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2)) - 1},
+        slots_{new Slot[mask_ + 1]} {
+    for (std::size_t i{0}; i <= mask_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+  ~MpmcRing() {
+    while (TryPop()) {
+    }
+    delete[] slots_;
+  }
+  MpmcRing(const MpmcRing&) = delete;
+  auto operator=(const MpmcRing&) -> MpmcRing& = delete;
+
+  template <typename... Args>
+  auto TryEmplace(Args&&... args) -> bool {
+    auto tail = tail_.load(std::memory_order_relaxed);
+    Slot* slot{nullptr};
+    for (;;) {
+      slot = &slots_[tail & mask_];
+      const auto sequence = slot->sequence.load(std::memory_order_acquire);
+      const auto lap = static_cast<std::intptr_t>(sequence - tail);
+      if (lap == 0) {
+        if (tail_.compare_exchange_weak(tail, tail + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (lap < 0) {
+        return false;  // full
+      } else {
+        tail = tail_.load(std::memory_order_relaxed);
+      }
+    }
+    new (slot->Value()) T(std::forward<Args>(args)...);
+    slot->sequence.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto TryPush(T value) -> bool { return TryEmplace(std::move(value)); }
+
+  auto TryPop() -> std::optional<T> {
+    auto head = head_.load(std::memory_order_relaxed);
+    Slot* slot{nullptr};
+    for (;;) {
+      slot = &slots_[head & mask_];
+      const auto sequence = slot->sequence.load(std::memory_order_acquire);
+      const auto lap = static_cast<std::intptr_t>(sequence - (head + 1));
+      if (lap == 0) {
+        if (head_.compare_exchange_weak(head, head + 1,
+                                        std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (lap < 0) {
+        return std::nullopt;  // empty
+      } else {
+        head = head_.load(std::memory_order_relaxed);
+      }
+    }
+    std::optional<T> value{std::move(*slot->Value())};
+    slot->Value()->~T();
+    slot->sequence.store(head + mask_ + 1, std::memory_order_release);
+    return value;
+  }
+
+  auto Capacity() const -> std::size_t { return mask_ + 1; }
+
+ private:
+  struct alignas(kCacheLineSize) Slot {
+    auto Value() -> T* { return std::launder(reinterpret_cast<T*>(bytes)); }
+
+    std::atomic<std::size_t> sequence;
+    alignas(T) unsigned char bytes[sizeof(T)];
+  };
+
+  alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+  alignas(kCacheLineSize) const std::size_t mask_;
+  Slot* const slots_;
+};
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_MPMC_RING_H
+)tmpl"};
+
+constexpr std::string_view kWorkStealingDequeHeader{R"tmpl(#ifndef @GUARD@_WORK_STEALING_DEQUE_H
+#define @GUARD@_WORK_STEALING_DEQUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include "@NAME@/cache_line.h"
+
+namespace @NS@ {
+
+// Chase-Lev work-stealing deque ("Dynamic circular work-stealing deque",
+// Chase and Lev, with the memory orders of Le et al., "Correct and efficient
+// work-stealing for weak memory models"). The owner thread pushes and pops at
+// the bottom, any other thread steals from the top. The buffer grows when
+// full; replaced buffers are kept until the deque is destroyed because a
+// thief may still read from them.
+//
+// Instead of the stand-alone fences of the paper, the accesses that need
+// them are sequentially consistent. That costs one locked instruction in Pop
+// on x86 but keeps ThreadSanitizer, which doesn't model fences, free of false
+// reports.
+//
+// T is copied while it may be concurrently overwritten, so it must be
+// trivially copyable, typically a pointer or an index.
+template <typename T>
+class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "WorkStealingDeque requires a trivially copyable type");
+
+ public:
+  // The capacity is rounded up to a power of two.
+  explicit WorkStealingDeque(std::size_t capacity = 1024) {
+    buffers_.push_back(std::make_unique<Buffer>(
+        RoundUpToPowerOfTwo(std::max<std::size_t>(capacity, 2))));
+    buffer_.store(buffers_.back().get(), std::memory_order_relaxed);
+  }
+  WorkStealingDeque(const WorkStealingDeque&) = delete;
+  auto operator=(const WorkStealingDeque&) -> WorkStealingDeque& = delete;
+
+  // Owner thread only.
+  auto Push(T value) -> void {
+    const auto bottom = bottom_.load(std::memory_order_relaxed);
+    const auto top = top_.load(std::memory_order_acquire);
+    auto* buffer = buffer_.load(std::memory_order_relaxed);
+    if (bottom - top > static_cast<std::int64_t>(buffer->mask)) {
+      buffer = Grow(buffer, top, bottom);
+    }
+    buffer->Store(bottom, value);
+    bottom_.store(bottom + 1, std::memory_order_release);
+  }
+
+  // Owner thread only. Takes the most recently pushed element.
+  auto Pop() -> std::optional<T> {
+    const auto bottom = bottom_.load(std::memory_order_relaxed) - 1;
+    auto* buffer = buffer_.load(std::memory_order_relaxed);
+    bottom_.store(bottom, std::memory_order_seq_cst);
+    auto top = top_.load(std::memory_order_seq_cst);
+    if (top > bottom) {
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+    const auto value = buffer->Load(bottom);
+    if (top == bottom) {
+      // Last element, race against the thieves for it.
+      const bool won = top_.compare_exchange_strong(
+          top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+      bottom_.store(bottom + 1, std::memory_order_relaxed);
+      if (!won) {
+        return std::nullopt;
+      }
+    }
+    return value;
+  }
+
+  // Any thread. Takes the oldest element. Returns std::nullopt when the deque
+  // is empty or another thread took the element first.
+  auto Steal() -> std::optional<T> {
+    auto top = top_.load(std::memory_order_seq_cst);
+    const auto bottom = bottom_.load(std::memory_order_seq_cst);
+    if (top >= bottom) {
+      return std::nullopt;
+    }
+    const auto value = buffer_.load(std::memory_order_acquire)->Load(top);
+    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+  // Approximate when other threads push or pop concurrently.
+  auto Size() const -> std::size_t {
+    const auto bottom = bottom_.load(std::memory_order_relaxed);
+    const auto top = top_.load(std::memory_order_relaxed);
+    return bottom > top ? static_cast<std::size_t>(bottom - top) : 0;
+  }
+
+ private:
+  struct Buffer {
+    explicit Buffer(std::size_t capacity)
+        : mask{capacity - 1},
+          elements{std::make_unique<std::atomic<T>[]>(capacity)} {}
+
+    auto Load(std::int64_t index) const -> T {
+      return elements[static_cast<std::size_t>(index) & mask].load(
+          std::memory_order_relaxed);
+    }
+    auto Store(std::int64_t index, T value) -> void {
+      elements[static_cast<std::size_t>(index) & mask].store(
+          value, std::memory_order_relaxed);
+    }
+
+    const std::size_t mask;
+    std::unique_ptr<std::atomic<T>[]> elements;
+  };
+
+  auto Grow(Buffer* buffer, std::int64_t top, std::int64_t bottom) -> Buffer* {
+    buffers_.push_back(std::make_unique<Buffer>(2 * (buffer->mask + 1)));
+    auto* grown = buffers_.back().get();
+    for (auto i = top; i < bottom; ++i) {
+      grown->Store(i, buffer->Load(i));
+    }
+    buffer_.store(grown, std::memory_order_release);
+    return grown;
+  }
+
+  alignas(kCacheLineSize) std::atomic<std::int64_t> top_{0};
+  alignas(kCacheLineSize) std::atomic<std::int64_t> bottom_{0};
+  std::atomic<Buffer*> buffer_{nullptr};
+  // Owner thread only.
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+};
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_WORK_STEALING_DEQUE_H
+)tmpl"};
+
+constexpr std::string_view kThreadPoolHeader{R"tmpl(#ifndef @GUARD@_THREAD_POOL_H
+#define @GUARD@_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "@NAME@/cache_line.h"
+#include "@NAME@/work_stealing_deque.h"
+
+namespace @NS@ {
+
+// Work-stealing thread pool. Every worker owns a WorkStealingDeque: tasks
+// submitted from a worker are pushed to its own deque and popped in LIFO
+// order, which keeps the working set in cache. Idle workers steal the oldest
+// tasks of the other workers. Tasks submitted from other threads go through a
+// shared injection queue. Workers spin briefly before they sleep.
+class ThreadPool {
+ public:
+  using Task = std::function<void()>;
+
+  // Starts threads workers, or one per hardware thread when 0.
+  explicit ThreadPool(std::size_t threads = 0);
+  // Runs the remaining tasks before joining the workers.
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  auto operator=(const ThreadPool&) -> ThreadPool& = delete;
+
+  auto Submit(Task task) -> void;
+  // Blocks until every submitted task, including the tasks they submitted,
+  // has finished. Must not be called from a task.
+  auto Wait() -> void;
+
+  auto Size() const -> std::size_t { return workers_.size(); }
+
+ private:
+  struct alignas(kCacheLineSize) Worker {
+    WorkStealingDeque<Task*> deque;
+    std::thread thread;
+  };
+
+  auto Run(std::size_t index) -> void;
+  auto Find(std::size_t index, uint64_t& random) -> Task*;
+  auto Execute(Task* task) -> void;
+  auto WakeOne() -> void;
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+
+  std::mutex injection_mutex_;
+  std::deque<Task*> injection_;
+
+  // Tasks submitted but not taken by a worker yet.
+  alignas(kCacheLineSize) std::atomic<int64_t> queued_{0};
+  // Tasks submitted but not finished yet.
+  alignas(kCacheLineSize) std::atomic<int64_t> unfinished_{0};
+  alignas(kCacheLineSize) std::atomic<uint32_t> sleeping_{0};
+  std::atomic<bool> stop_{false};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  std::condition_variable idle_;
+};
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_THREAD_POOL_H
+)tmpl"};
+
+constexpr std::string_view kThreadPoolSource{R"tmpl(#include "@NAME@/thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace @NS@ {
+namespace {
+
+// Worker of the pool the current thread belongs to.
+thread_local const void* current_pool{nullptr};
+thread_local std::size_t current_worker{0};
+
+constexpr int kSpinRounds{64};
+
+auto NextRandom(uint64_t& state) -> uint64_t {
+  state ^= state << 13U;
+  state ^= state >> 7U;
+  state ^= state << 17U;
+  return state;
+}
+
+}  // namespace
+
+ThreadPool::ThreadPool(std::size_t threads) {
+  if (threads == 0) {
+    threads = std::max(1U, std::thread::hardware_concurrency());
+  }
+  workers_.reserve(threads);
+  for (std::size_t i{0}; i < threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (std::size_t i{0}; i < threads; ++i) {
+    workers_[i]->thread = std::thread{[this, i] { Run(i); }};
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  Wait();
+  {
+    const std::lock_guard<std::mutex> lock{sleep_mutex_};
+    stop_.store(true);
+  }
+  wake_.notify_all();
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+auto ThreadPool::Submit(Task task) -> void {
+  auto* owned = new Task{std::move(task)};
+  unfinished_.fetch_add(1);
+  if (current_pool == this) {
+    workers_[current_worker]->deque.Push(owned);
+  } else {
+    const std::lock_guard<std::mutex> lock{injection_mutex_};
+    injection_.push_back(owned);
+  }
+  queued_.fetch_add(1);
+  // Pairs with the increment of sleeping_ in Run: either this thread sees
+  // the sleeper, or the sleeper sees the queued task.
+  if (sleeping_.load() > 0) {
+    WakeOne();
+  }
+}
+
+auto ThreadPool::Wait() -> void {
+  std::unique_lock<std::mutex> lock{sleep_mutex_};
+  idle_.wait(lock, [this] { return unfinished_.load() == 0; });
+}
+
+auto ThreadPool::WakeOne() -> void {
+  { const std::lock_guard<std::mutex> lock{sleep_mutex_}; }
+  wake_.notify_one();
+}
+
+auto ThreadPool::Find(std::size_t index, uint64_t& random) -> Task* {
+  if (auto task = workers_[index]->deque.Pop()) {
+    return *task;
+  }
+  {
+    const std::lock_guard<std::mutex> lock{injection_mutex_};
+    if (!injection_.empty()) {
+      auto* task = injection_.front();
+      injection_.pop_front();
+      return task;
+    }
+  }
+  const auto count = workers_.size();
+  const auto start = NextRandom(random) % count;
+  for (std::size_t i{0}; i < count; ++i) {
+    const auto victim = (start + i) % count;
+    if (victim == index) {
+      continue;
+    }
+    if (auto task = workers_[victim]->deque.Steal()) {
+      return *task;
+    }
+  }
+  return nullptr;
+}
+
+auto ThreadPool::Execute(Task* task) -> void {
+  queued_.fetch_sub(1);
+  (*task)();
+  delete task;
+  if (unfinished_.fetch_sub(1) == 1) {
+    { const std::lock_guard<std::mutex> lock{sleep_mutex_}; }
+    idle_.notify_all();
+  }
+}
+
+auto ThreadPool::Run(std::size_t index) -> void {
+  current_pool = this;
+  current_worker = index;
+  uint64_t random{index + 1};
+  for (;;) {
+    Task* task{nullptr};
+    for (int round{0}; task == nullptr && round < kSpinRounds; ++round) {
+      task = Find(index, random);
+      if (task == nullptr) {
+        if (queued_.load() == 0) {
+          break;
+        }
+        std::this_thread::yield();
+      }
+    }
+    if (task != nullptr) {
+      Execute(task);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock{sleep_mutex_};
+    sleeping_.fetch_add(1);
+    wake_.wait(lock, [this] { return queued_.load() > 0 || stop_.load(); });
+    sleeping_.fetch_sub(1);
+    if (stop_.load() && queued_.load() == 0) {
+      return;
+    }
+  }
+}
+
+}  // namespace @NS@
+)tmpl"};
+
+constexpr std::string_view kConcurrencyTestsSource{R"tmpl(// Stress tests for the concurrency primitives. Build them with
+// @UPPER@_ENABLE_TSAN=ON to run them under ThreadSanitizer.
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include "@NAME@/mpmc_ring.h"
+#include "@NAME@/spsc_ring.h"
+#include "@NAME@/thread_pool.h"
+#include "@NAME@/work_stealing_deque.h"
+
+namespace {
+
+constexpr uint64_t kItems{200000};
+
+}  // namespace
+
+TEST_CASE("SpscRing keeps the order of the elements", "[spsc]") {
+  @NS@::SpscRing<uint64_t> ring{64};
+  REQUIRE(ring.Capacity() == 64);
+  std::thread producer{[&ring] {
+    for (uint64_t i{0}; i < kItems; ++i) {
+      while (!ring.TryPush(i)) {
+        std::this_thread::yield();
+      }
+    }
+  }};
+  uint64_t expected{0};
+  while (expected < kItems) {
+    if (const auto value = ring.TryPop()) {
+      REQUIRE(*value == expected);
+      ++expected;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  producer.join();
+  REQUIRE_FALSE(ring.TryPop());
+}
+
+TEST_CASE("SpscRing destroys the remaining elements", "[spsc]") {
+  auto counter = std::make_shared<int>(0);
+  {
+    @NS@::SpscRing<std::shared_ptr<int>> ring{4};
+    REQUIRE(ring.TryPush(counter));
+    REQUIRE(ring.TryPush(counter));
+    REQUIRE(counter.use_count() == 3);
+  }
+  REQUIRE(counter.use_count() == 1);
+}
+
+TEST_CASE("MpmcRing delivers every element exactly once", "[mpmc]") {
+  constexpr unsigned kProducers{4};
+  constexpr unsigned kConsumers{4};
+  constexpr uint64_t kPerProducer{kItems / kProducers};
+  @NS@::MpmcRing<uint64_t> ring{256};
+  std::vector<std::atomic<uint32_t>> seen(kProducers * kPerProducer);
+  std::atomic<uint64_t> consumed{0};
+  std::vector<std::thread> threads;
+  for (unsigned p{0}; p < kProducers; ++p) {
+    threads.emplace_back([&ring, p] {
+      for (uint64_t i{0}; i < kPerProducer; ++i) {
+        while (!ring.TryPush(p * kPerProducer + i)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (unsigned c{0}; c < kConsumers; ++c) {
+    threads.emplace_back([&] {
+      while (consumed.load() < kProducers * kPerProducer) {
+        if (const auto value = ring.TryPop()) {
+          seen[*value].fetch_add(1);
+          consumed.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (const auto& count : seen) {
+    REQUIRE(count.load() == 1);
+  }
+}
+
+TEST_CASE("WorkStealingDeque grows and pops in LIFO order", "[deque]") {
+  @NS@::WorkStealingDeque<uint64_t> deque{2};
+  for (uint64_t i{0}; i < 1000; ++i) {
+    deque.Push(i);
+  }
+  REQUIRE(deque.Size() == 1000);
+  REQUIRE(*deque.Steal() == 0);
+  for (uint64_t i{999}; i > 0; --i) {
+    REQUIRE(*deque.Pop() == i);
+  }
+  REQUIRE_FALSE(deque.Pop());
+  REQUIRE_FALSE(deque.Steal());
+}
+
+TEST_CASE("WorkStealingDeque hands out every element exactly once",
+          "[deque]") {
+  constexpr unsigned kThieves{3};
+  @NS@::WorkStealingDeque<uint64_t> deque{16};
+  std::vector<std::atomic<uint32_t>> seen(kItems);
+  std::atomic<uint64_t> taken{0};
+  std::vector<std::thread> thieves;
+  for (unsigned t{0}; t < kThieves; ++t) {
+    thieves.emplace_back([&] {
+      while (taken.load() < kItems) {
+        if (const auto value = deque.Steal()) {
+          seen[*value].fetch_add(1);
+          taken.fetch_add(1);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (uint64_t i{0}; i < kItems; ++i) {
+    deque.Push(i);
+    // Pop some elements to race with the thieves for the last element.
+    if (i % 3 == 0) {
+      if (const auto value = deque.Pop()) {
+        seen[*value].fetch_add(1);
+        taken.fetch_add(1);
+      }
+    }
+  }
+  while (const auto value = deque.Pop()) {
+    seen[*value].fetch_add(1);
+    taken.fetch_add(1);
+  }
+  for (auto& thief : thieves) {
+    thief.join();
+  }
+  for (const auto& count : seen) {
+    REQUIRE(count.load() == 1);
+  }
+}
+
+TEST_CASE("ThreadPool runs every task", "[pool]") {
+  @NS@::ThreadPool pool{4};
+  std::atomic<uint64_t> sum{0};
+  for (uint64_t i{1}; i <= 10000; ++i) {
+    pool.Submit([&sum, i] { sum.fetch_add(i); });
+  }
+  pool.Wait();
+  REQUIRE(sum.load() == 10000ULL * 10001ULL / 2);
+}
+
+namespace {
+
+// Submits a binary tree of tasks from inside the pool.
+auto Spawn(@NS@::ThreadPool& pool, std::atomic<uint64_t>& leaves, int depth)
+    -> void {
+  if (depth == 0) {
+    leaves.fetch_add(1);
+    return;
+  }
+  pool.Submit([&pool, &leaves, depth] { Spawn(pool, leaves, depth - 1); });
+  pool.Submit([&pool, &leaves, depth] { Spawn(pool, leaves, depth - 1); });
+}
+
+}  // namespace
+
+TEST_CASE("ThreadPool runs tasks submitted by tasks", "[pool]") {
+  @NS@::ThreadPool pool{4};
+  std::atomic<uint64_t> leaves{0};
+  for (int round{0}; round < 10; ++round) {
+    leaves.store(0);
+    pool.Submit([&pool, &leaves] { Spawn(pool, leaves, 12); });
+    pool.Wait();
+    REQUIRE(leaves.load() == 4096);
+  }
+}
+)tmpl"};
+
+constexpr std::string_view kThroughputBenchSource{R"tmpl(// Throughput of the concurrency primitives:
+//
+//   @NAME@_bench [--threads N] [--ops N]
+//
+// spsc:  one producer and one consumer thread.
+// mpmc:  N/2 producers and N/2 consumers.
+// deque: the owner pushes and pops while N-1 threads steal.
+// pool:  empty tasks submitted from inside the pool.
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "@NAME@/mpmc_ring.h"
+#include "@NAME@/spsc_ring.h"
+#include "@NAME@/thread_pool.h"
+#include "@NAME@/work_stealing_deque.h"
+
+namespace {
+
+struct Options {
+  unsigned threads{std::max(2U, std::thread::hardware_concurrency())};
+  uint64_t operations{10000000};
+};
+
+template <typename T>
+auto Parse(std::string_view text, T& value) -> bool {
+  const auto* end = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+  return ec == std::errc{} && ptr == end;
+}
+
+template <typename Function>
+auto Measure(const char* name, uint64_t operations, Function function)
+    -> void {
+  const auto start = std::chrono::steady_clock::now();
+  function();
+  const std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() -
+                                              start};
+  std::printf("%-6s %10.2f Mops/s %8.1f ns/op\n", name,
+              static_cast<double>(operations) / elapsed.count() / 1e6,
+              elapsed.count() * 1e9 / static_cast<double>(operations));
+}
+
+auto Spsc(const Options& options) -> void {
+  @NS@::SpscRing<uint64_t> ring{4096};
+  Measure("spsc", options.operations, [&] {
+    std::thread producer{[&] {
+      for (uint64_t i{0}; i < options.operations; ++i) {
+        while (!ring.TryPush(i)) {
+        }
+      }
+    }};
+    for (uint64_t i{0}; i < options.operations;) {
+      i += ring.TryPop().has_value() ? 1 : 0;
+    }
+    producer.join();
+  });
+}
+
+auto Mpmc(const Options& options) -> void {
+  const auto producers = std::max(1U, options.threads / 2);
+  const auto consumers = std::max(1U, options.threads - producers);
+  const auto per_producer = options.operations / producers;
+  const auto total = per_producer * producers;
+  @NS@::MpmcRing<uint64_t> ring{4096};
+  std::atomic<uint64_t> consumed{0};
+  Measure("mpmc", total, [&] {
+    std::vector<std::thread> threads;
+    for (unsigned p{0}; p < producers; ++p) {
+      threads.emplace_back([&] {
+        for (uint64_t i{0}; i < per_producer; ++i) {
+          while (!ring.TryPush(i)) {
+            std::this_thread::yield();
+          }
+        }
+      });
+    }
+    for (unsigned c{0}; c < consumers; ++c) {
+      threads.emplace_back([&] {
+        while (consumed.load(std::memory_order_relaxed) < total) {
+          if (ring.TryPop()) {
+            consumed.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  });
+}
+
+auto Deque(const Options& options) -> void {
+  @NS@::WorkStealingDeque<uint64_t> deque;
+  std::atomic<uint64_t> taken{0};
+  Measure("deque", options.operations, [&] {
+    std::vector<std::thread> thieves;
+    for (unsigned t{1}; t < options.threads; ++t) {
+      thieves.emplace_back([&] {
+        while (taken.load(std::memory_order_relaxed) < options.operations) {
+          if (deque.Steal()) {
+            taken.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      });
+    }
+    for (uint64_t i{0}; i < options.operations; ++i) {
+      deque.Push(i);
+      if (i % 2 == 0 && deque.Pop()) {
+        taken.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    while (deque.Pop()) {
+      taken.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (auto& thief : thieves) {
+      thief.join();
+    }
+  });
+}
+
+auto Pool(const Options& options) -> void {
+  @NS@::ThreadPool pool{options.threads};
+  const auto tasks = options.operations / 10;
+  std::atomic<uint64_t> done{0};
+  Measure("pool", tasks, [&] {
+    // Every worker gets a root task that submits its share of the tasks.
+    const auto per_root = tasks / pool.Size();
+    for (std::size_t r{0}; r < pool.Size(); ++r) {
+      pool.Submit([&pool, &done, per_root] {
+        for (uint64_t i{0}; i < per_root; ++i) {
+          pool.Submit(
+              [&done] { done.fetch_add(1, std::memory_order_relaxed); });
+        }
+      });
+    }
+    pool.Wait();
+  });
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i{1}; i < argc; i += 2) {
+    const std::string_view key{argv[i]};
+    const std::string_view value{i + 1 < argc ? argv[i + 1] : ""};
+    bool ok{false};
+    if (key == "--threads") {
+      ok = Parse(value, options.threads) && options.threads > 1;
+    } else if (key == "--ops") {
+      ok = Parse(value, options.operations) && options.operations > 0;
+    }
+    if (!ok) {
+      std::fprintf(stderr, "usage: %s [--threads N>1] [--ops N]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  std::printf("%u threads, %llu operations\n", options.threads,
+              static_cast<unsigned long long>(options.operations));
+  Spsc(options);
+  Mpmc(options);
+  Deque(options);
+  Pool(options);
+  return EXIT_SUCCESS;
+}
+)tmpl"};
+
+}  // namespace
+
+auto WriteConcurrencyProfile(const std::filesystem::path& project_path,
+                             const LibraryParams* param) -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteConcurrencyProfile")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteConcurrencyProfile") << "param is a nullptr";
+    return 2;
+  }
+  const auto include_path = project_path / "include" / param->name;
+  const auto src_path = project_path / "src";
+  const auto test_src_path = project_path / "tests" / "src";
+  const auto bench_path = project_path / "bench";
+  std::error_code error_code;
+  std::filesystem::create_directories(bench_path, error_code);
+  if (error_code) {
+    Log(LogLevel::kError, "WriteConcurrencyProfile")
+        .Field("errno", error_code.value())
+        .Field("error", error_code.message())
+        << "failed to create directory: " << bench_path;
+    return 3;
+  }
+
+  const auto substitutions =
+      ProjectSubstitutions(param->name, param->cpp_namespace);
+  const std::pair<std::filesystem::path, std::string_view> files[]{
+      {include_path / "cache_line.h", kCacheLineHeader},
+      {include_path / "spsc_ring.h", kSpscRingHeader},
+      {include_path / "mpmc_ring.h", kMpmcRingHeader},
+      {include_path / "work_stealing_deque.h", kWorkStealingDequeHeader},
+      {include_path / "thread_pool.h", kThreadPoolHeader},
+      {src_path / "thread_pool.cpp", kThreadPoolSource},
+      {test_src_path / "concurrency_tests.cpp", kConcurrencyTestsSource},
+      {bench_path / "throughput.cpp", kThroughputBenchSource},
+  };
+  for (const auto& [path, text] : files) {
+    if (WriteTextFile(path, Substitute(text, substitutions)) != 0) {
+      Log(LogLevel::kError, "WriteConcurrencyProfile") << "failed to write "
+                                                       << path;
+      return 4;
+    }
+  }
+  return 0;
+}
+
+}  // namespace ci
@@ -0,0 +1,131 @@
+#include "cpp_init/console.h"
+
+#include <unistd.h>
+
+#include <cctype>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+
+namespace ci {
+namespace {
+
+constexpr std::size_t kBufferSize{4096};
+
+// Zero-initialized, so they need no constructor at startup.
+struct OutputBuffer {
+  char data[kBufferSize];
+  std::size_t size;
+} output;
+
+struct InputBuffer {
+  char data[kBufferSize];
+  std::size_t begin;
+  std::size_t end;
+  bool eof;
+  // Set when a word was requested after the end of the input.
+  bool ended;
+} input;
+
+auto WriteAll(int fd, std::string_view text) -> void {
+  while (!text.empty()) {
+    const auto written = ::write(fd, text.data(), text.size());
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    text.remove_prefix(static_cast<std::size_t>(written));
+  }
+}
+
+// Returns false at the end of the input or on a read error.
+auto Fill() -> bool {
+  if (input.eof) {
+    return false;
+  }
+  while (true) {
+    const auto count = ::read(STDIN_FILENO, input.data, kBufferSize);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      input.eof = true;
+      return false;
+    }
+    input.begin = 0;
+    input.end = static_cast<std::size_t>(count);
+    return true;
+  }
+}
+
+auto IsSpace(char c) -> bool {
+  return std::isspace(static_cast<unsigned char>(c)) != 0;
+}
+
+}  // namespace
+
+auto ConsoleWrite(std::string_view text) -> void {
+  if (output.size + text.size() > kBufferSize) {
+    FlushConsole();
+    if (text.size() > kBufferSize) {
+      WriteAll(STDOUT_FILENO, text);
+      return;
+    }
+  }
+  std::memcpy(output.data + output.size, text.data(), text.size());
+  output.size += text.size();
+}
+
+auto ConsoleWrite(std::size_t value) -> void {
+  char text[24];
+  const auto [end, ec] = std::to_chars(text, text + sizeof(text), value);
+  ConsoleWrite(std::string_view(text, static_cast<std::size_t>(end - text)));
+}
+
+auto FlushConsole() -> void {
+  WriteAll(STDOUT_FILENO, std::string_view(output.data, output.size));
+  output.size = 0;
+}
+
+auto ConsoleError(std::string_view text) -> void {
+  WriteAll(STDERR_FILENO, text);
+}
+
+auto ConsoleReadWord() -> std::optional<std::string> {
+  FlushConsole();
+  // Skips the whitespace before the word.
+  while (true) {
+    while (input.begin < input.end && IsSpace(input.data[input.begin])) {
+      ++input.begin;
+    }
+    if (input.begin < input.end) {
+      break;
+    }
+    if (!Fill()) {
+      input.ended = true;
+      return std::nullopt;
+    }
+  }
+  std::string word;
+  while (true) {
+    const auto* begin = input.data + input.begin;
+    const auto* end = input.data + input.end;
+    const auto* stop = begin;
+    while (stop != end && !IsSpace(*stop)) {
+      ++stop;
+    }
+    word.append(begin, stop);
+    input.begin += static_cast<std::size_t>(stop - begin);
+    if (stop != end || !Fill()) {
+      return word;
+    }
+  }
+}
+
+auto ConsoleInputEnded() -> bool {
+  return input.ended;
+}
+
+}  // namespace ci
@@ -0,0 +1,399 @@
+#include "cpp_init/deps.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "cpp_init/cli.h"
+#include "cpp_init/console.h"
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+constexpr std::string_view kDepsCacheCmake{R"(# Dependencies prebuilt by `cpp_init deps` are shared between projects. They
+# are installed per compiler, ABI and C++ standard below CPP_INIT_DEPS_ROOT and
+# that prefix is searched before the system locations.
+if (DEFINED ENV{CPP_INIT_DEPS_ROOT})
+    set(CPP_INIT_DEPS_DEFAULT_ROOT $ENV{CPP_INIT_DEPS_ROOT})
+elseif (DEFINED ENV{XDG_CACHE_HOME})
+    set(CPP_INIT_DEPS_DEFAULT_ROOT $ENV{XDG_CACHE_HOME}/cpp_init/deps)
+else ()
+    set(CPP_INIT_DEPS_DEFAULT_ROOT $ENV{HOME}/.cache/cpp_init/deps)
+endif ()
+set(CPP_INIT_DEPS_ROOT ${CPP_INIT_DEPS_DEFAULT_ROOT} CACHE PATH
+        "Root directory of the prebuilt dependency cache")
+if (NOT DEFINED CPP_INIT_DEPS_CXX_STANDARD)
+    set(CPP_INIT_DEPS_CXX_STANDARD 17)
+endif ()
+
+# Flags that select another standard library or library ABI get their own
+# prefix.
+string(REGEX MATCHALL "-stdlib=[^ ]+|-D_GLIBCXX_USE_CXX11_ABI=[01]"
+        CPP_INIT_DEPS_ABI_FLAGS "${CMAKE_CXX_FLAGS}")
+string(REPLACE ";" "" CPP_INIT_DEPS_ABI_FLAGS "${CPP_INIT_DEPS_ABI_FLAGS}")
+string(REGEX REPLACE "[^A-Za-z0-9_.+]+" "_" CPP_INIT_DEPS_ABI_FLAGS
+        "${CPP_INIT_DEPS_ABI_FLAGS}")
+set(CPP_INIT_DEPS_KEY
+        "${CMAKE_CXX_COMPILER_ID}-${CMAKE_CXX_COMPILER_VERSION}-${CMAKE_SYSTEM_PROCESSOR}-cxx${CPP_INIT_DEPS_CXX_STANDARD}${CPP_INIT_DEPS_ABI_FLAGS}")
+string(TOLOWER ${CPP_INIT_DEPS_KEY} CPP_INIT_DEPS_KEY)
+set(CPP_INIT_DEPS_PREFIX ${CPP_INIT_DEPS_ROOT}/${CPP_INIT_DEPS_KEY})
+
+if (EXISTS ${CPP_INIT_DEPS_PREFIX})
+    list(PREPEND CMAKE_PREFIX_PATH ${CPP_INIT_DEPS_PREFIX})
+endif ()
+)"};
+
+// A dependency used by the project templates. The source archive is the file
+// in the sources directory whose name starts with archive_prefix.
+struct Dependency {
+  std::string_view name;
+  std::string_view archive_prefix;
+  std::vector<std::string_view> cmake_args;
+};
+
+auto KnownDependencies() -> std::vector<Dependency> {
+  return {
+      {"Catch2",
+       "Catch2",
+       {"-DBUILD_TESTING=OFF", "-DCATCH_INSTALL_DOCS=OFF",
+        "-DCATCH_INSTALL_EXTRAS=ON"}},
+  };
+}
+
+struct DepsOptions {
+  std::filesystem::path sources;
+  std::filesystem::path root;
+  uint8_t cpp_standard{17};
+  uint32_t jobs{0};
+  bool force{false};
+};
+
+auto PrintUsage() -> void {
+  ConsoleError(
+      "usage: cpp_init deps --sources DIR [--root DIR]\n"
+      "                     [--cxx-standard N] [--jobs N] [--force]\n"
+      "\n"
+      "Builds the dependencies used by generated projects from the\n"
+      "source archives in DIR and installs them into the shared\n"
+      "cache below the root (default: $CPP_INIT_DEPS_ROOT or\n"
+      "~/.cache/cpp_init/deps).\n");
+}
+
+auto DefaultRoot() -> std::filesystem::path {
+  if (const auto* root = std::getenv("CPP_INIT_DEPS_ROOT"); root != nullptr) {
+    return root;
+  }
+  if (const auto* cache = std::getenv("XDG_CACHE_HOME"); cache != nullptr) {
+    return std::filesystem::path{cache} / "cpp_init" / "deps";
+  }
+  const auto* home = std::getenv("HOME");
+  return std::filesystem::path{home != nullptr ? home : "."} / ".cache" /
+         "cpp_init" / "deps";
+}
+
+auto ParseDepsOptions(const std::vector<std::string_view>& args)
+    -> std::optional<DepsOptions> {
+  DepsOptions options;
+  options.root = DefaultRoot();
+  for (std::size_t i{0}; i < args.size(); ++i) {
+    const auto key = args[i];
+    if (key == "--force") {
+      options.force = true;
+      continue;
+    }
+    if (i + 1 >= args.size()) {
+      return std::nullopt;
+    }
+    const auto value = args[++i];
+    if (key == "--sources") {
+      options.sources = value;
+    } else if (key == "--root") {
+      options.root = value;
+    } else if (key == "--cxx-standard") {
+      if (!ParseNumber(value, options.cpp_standard)) {
+        return std::nullopt;
+      }
+    } else if (key == "--jobs") {
+      if (!ParseNumber(value, options.jobs)) {
+        return std::nullopt;
+      }
+    } else {
+      return std::nullopt;
+    }
+  }
+  if (options.sources.empty()) {
+    return std::nullopt;
+  }
+  if (options.jobs == 0) {
+    options.jobs = std::max(1U, std::thread::hardware_concurrency());
+  }
+  return options;
+}
+
+auto Quote(std::string_view arg) -> std::string {
+  std::string quoted{"'"};
+  for (const auto c : arg) {
+    if (c == '\'') {
+      quoted += "'\\''";
+    } else {
+      quoted.push_back(c);
+    }
+  }
+  quoted.push_back('\'');
+  return quoted;
+}
+
+auto Run(const std::vector<std::string>& args) -> bool {
+  std::string command;
+  for (const auto& arg : args) {
+    if (!command.empty()) {
+      command.push_back(' ');
+    }
+    command += Quote(arg);
+  }
+  Log(LogLevel::kInfo, "deps") << command;
+  return std::system(command.c_str()) == 0;
+}
+
+auto ReadFile(const std::filesystem::path& path) -> std::string {
+  std::ifstream in(path.string(), std::ios_base::in | std::ios_base::binary);
+  std::ostringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+// Configures a throw-away project that includes deps_cache.cmake and reports
+// the prefix it computes for the compiler CMake picks up.
+auto ProbePrefix(const DepsOptions& options)
+    -> std::optional<std::filesystem::path> {
+  const auto probe_path =
+      options.root / (".probe-" + std::to_string(getpid()));
+  const auto build_path = probe_path / "build";
+  std::error_code error_code;
+  std::filesystem::create_directories(probe_path, error_code);
+  if (error_code) {
+    Log(LogLevel::kError, "RunDeps")
+        .Field("errno", error_code.value())
+        .Field("error", error_code.message())
+        << "failed to create directory: " << probe_path;
+    return std::nullopt;
+  }
+  std::optional<std::filesystem::path> prefix;
+  if (WriteTextFile(probe_path / "deps_cache.cmake", kDepsCacheCmake) == 0 &&
+      WriteTextFile(probe_path / "CMakeLists.txt",
+                    "cmake_minimum_required(VERSION 3.16)\n"
+                    "project(cpp_init_deps_probe LANGUAGES CXX)\n"
+                    "include(deps_cache.cmake)\n"
+                    "file(WRITE ${CMAKE_BINARY_DIR}/prefix.txt "
+                    "\"${CPP_INIT_DEPS_PREFIX}\")\n") == 0 &&
+      Run({"cmake", "-S", probe_path.string(), "-B", build_path.string(),
+           "-DCPP_INIT_DEPS_ROOT=" + options.root.string(),
+           "-DCPP_INIT_DEPS_CXX_STANDARD=" +
+               std::to_string(options.cpp_standard)})) {
+    prefix = ReadFile(build_path / "prefix.txt");
+  }
+  std::filesystem::remove_all(probe_path, error_code);
+  return prefix;
+}
+
+// Numeric components of the version that follows the prefix, e.g. {3, 10, 0}
+// for Catch2-3.10.0.tar.gz. Text between the numbers, like a leading "-v",
+// only separates them.
+auto ArchiveVersion(std::string_view file_name, std::string_view prefix)
+    -> std::vector<uint64_t> {
+  std::vector<uint64_t> version;
+  const auto* it = file_name.data() + prefix.size();
+  const auto* end = file_name.data() + file_name.size();
+  while (it != end) {
+    if (*it < '0' || *it > '9') {
+      ++it;
+      continue;
+    }
+    uint64_t component{0};
+    const auto [ptr, ec] = std::from_chars(it, end, component);
+    if (ec != std::errc{}) {
+      break;
+    }
+    version.push_back(component);
+    it = ptr;
+  }
+  return version;
+}
+
+auto FindArchive(const std::filesystem::path& sources,
+                 std::string_view archive_prefix)
+    -> std::optional<std::filesystem::path> {
+  constexpr std::string_view kExtensions[]{".tar.gz", ".tgz", ".tar.xz",
+                                           ".tar.bz2", ".zip"};
+  std::optional<std::filesystem::path> found;
+  std::vector<uint64_t> found_version;
+  for (const auto& entry : std::filesystem::directory_iterator(sources)) {
+    const auto file_name = entry.path().filename().string();
+    if (!entry.is_regular_file() || file_name.rfind(archive_prefix, 0) != 0) {
+      continue;
+    }
+    for (const auto extension : kExtensions) {
+      if (file_name.size() > extension.size() &&
+          file_name.compare(file_name.size() - extension.size(),
+                            extension.size(), extension) == 0) {
+        // Prefer the newest version when several archives are present.
+        // Versions compare by their numeric components, so 3.10.0 is newer
+        // than 3.9.0; equal versions fall back to the file name.
+        auto version = ArchiveVersion(file_name, archive_prefix);
+        if (!found || found_version < version ||
+            (found_version == version &&
+             found->filename() < entry.path().filename())) {
+          found = entry.path();
+          found_version = std::move(version);
+        }
+      }
+    }
+  }
+  return found;
+}
+
+// Name, size and FNV-1a hash of the archive, stored in the stamp so that a
+// different archive with the same name is rebuilt.
+auto ArchiveIdentity(const std::filesystem::path& archive) -> std::string {
+  std::ifstream in(archive, std::ios_base::binary);
+  uint64_t hash{14695981039346656037ULL};
+  uint64_t size{0};
+  std::array<char, 65536> buffer{};
+  while (in.read(buffer.data(), buffer.size()) || in.gcount() > 0) {
+    const auto count = static_cast<std::size_t>(in.gcount());
+    for (std::size_t i{0}; i < count; ++i) {
+      hash ^= static_cast<unsigned char>(buffer[i]);
+      hash *= 1099511628211ULL;
+    }
+    size += count;
+  }
+  char hex[17];
+  const auto [end, ec] = std::to_chars(hex, hex + 16, hash, 16);
+  return archive.filename().string() + " size=" + std::to_string(size) +
+         " fnv1a=" + std::string(hex, end);
+}
+
+// The archive is expected to contain a single top-level directory, like the
+// release archives of GitHub.
+auto SourceRoot(const std::filesystem::path& extract_path)
+    -> std::filesystem::path {
+  std::filesystem::path root{extract_path};
+  std::size_t count{0};
+  for (const auto& entry : std::filesystem::directory_iterator(extract_path)) {
+    root = entry.path();
+    ++count;
+  }
+  return count == 1 && is_directory(root) ? root : extract_path;
+}
+
+auto BuildDependency(const Dependency& dependency, const DepsOptions& options,
+                     const std::filesystem::path& prefix) -> int32_t {
+  const auto archive = FindArchive(options.sources, dependency.archive_prefix);
+  if (!archive) {
+    Log(LogLevel::kInfo, "deps") << "no source archive for " << dependency.name
+                                 << " in " << options.sources << ", skipped";
+    return 0;
+  }
+  const auto stamp =
+      prefix / ".cpp_init" / (std::string{dependency.name} + ".stamp");
+  const auto archive_name = archive->filename().string();
+  const auto identity = ArchiveIdentity(*archive);
+  if (!options.force && ReadFile(stamp) == identity) {
+    Log(LogLevel::kInfo, "deps") << dependency.name << " is up to date ("
+                                 << archive_name << ")";
+    return 0;
+  }
+
+  const auto work_path = prefix / ".cpp_init" / "build" / dependency.name;
+  const auto extract_path = work_path / "src";
+  const auto build_path = work_path / "build";
+  std::error_code error_code;
+  std::filesystem::remove_all(work_path, error_code);
+  std::filesystem::create_directories(extract_path, error_code);
+  if (error_code) {
+    Log(LogLevel::kError, "RunDeps")
+        .Field("errno", error_code.value())
+        .Field("error", error_code.message())
+        << "failed to create directory: " << extract_path;
+    return 3;
+  }
+  // cmake -E tar extracts into the working directory.
+  const auto archive_path = std::filesystem::absolute(*archive, error_code);
+  if (!Run({"cmake", "-E", "chdir", extract_path.string(), "cmake", "-E", "tar",
+            "xf", archive_path.string()})) {
+    Log(LogLevel::kError, "RunDeps") << "failed to extract " << *archive;
+    return 4;
+  }
+
+  std::vector<std::string> configure{
+      "cmake",
+      "-S",
+      SourceRoot(extract_path).string(),
+      "-B",
+      build_path.string(),
+      "-DCMAKE_BUILD_TYPE=Release",
+      "-DCMAKE_INSTALL_PREFIX=" + prefix.string(),
+      "-DCMAKE_PREFIX_PATH=" + prefix.string(),
+      "-DCMAKE_CXX_STANDARD=" + std::to_string(options.cpp_standard),
+      "-DCMAKE_POSITION_INDEPENDENT_CODE=ON",
+  };
+  for (const auto arg : dependency.cmake_args) {
+    configure.emplace_back(arg);
+  }
+  if (!Run(configure) ||
+      !Run({"cmake", "--build", build_path.string(), "--parallel",
+            std::to_string(options.jobs)}) ||
+      !Run({"cmake", "--install", build_path.string()})) {
+    Log(LogLevel::kError, "RunDeps") << "failed to build " << dependency.name;
+    return 5;
+  }
+  if (WriteTextFile(stamp, identity) != 0) {
+    return 6;
+  }
+  std::filesystem::remove_all(work_path.parent_path(), error_code);
+  Log(LogLevel::kInfo, "deps") << "installed " << dependency.name << " into "
+                               << prefix;
+  return 0;
+}
+
+}  // namespace
+
+auto DepsCacheCmake() -> std::string_view { return kDepsCacheCmake; }
+
+auto RunDeps(const std::vector<std::string_view>& args) -> int32_t {
+  const auto options = ParseDepsOptions(args);
+  if (!options) {
+    PrintUsage();
+    return 1;
+  }
+  if (!is_directory(options->sources)) {
+    Log(LogLevel::kError, "RunDeps") << "sources directory doesn't exist: "
+                                     << options->sources;
+    return 2;
+  }
+  const auto prefix = ProbePrefix(*options);
+  if (!prefix || prefix->empty()) {
+    Log(LogLevel::kError, "RunDeps") << "failed to determine the cache prefix";
+    return 2;
+  }
+  Log(LogLevel::kInfo, "deps") << "cache prefix " << *prefix;
+  for (const auto& dependency : KnownDependencies()) {
+    if (const auto rv = BuildDependency(dependency, *options, *prefix);
+        rv != 0) {
+      return rv;
+    }
+  }
+  return 0;
+}
+
+}  // namespace ci
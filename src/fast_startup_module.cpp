@@ -0,0 +1,251 @@
+#include "cpp_init/fast_startup_module.h"
+
+#include <string_view>
+#include <utility>
+
+#include "cpp_init/blob_store.h"
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+constexpr std::string_view kFastStartupCmake{R"cmake(# Compile and link options that shorten the startup of short-lived executables.
+#
+#   fast_startup(<target> [STATIC <bool>] [RELRO full|partial|none])
+#
+# - Hidden visibility leaves fewer symbols in the dynamic symbol table.
+# - -fno-plt calls shared library functions through the GOT instead of PLT
+#   stubs.
+# - -Bsymbolic binds references to the target's own symbols at link time.
+# - --hash-style=gnu gives the dynamic loader the faster GNU hash table.
+# - --as-needed drops shared libraries that aren't used, so they aren't
+#   loaded.
+# - Function and data sections with --gc-sections remove unreferenced code
+#   and data, leaving fewer pages to map and relocations to apply.
+# STATIC links everything statically, so no dynamic loader runs at all.
+# RELRO full (-z relro -z now) resolves every symbol at load time and makes
+# the GOT read-only, partial (-z relro -z lazy) resolves the remaining PLT
+# calls on first use and none (-z norelro -z lazy) also skips the mprotect of
+# the relocated data. partial is the default.
+
+include_guard(GLOBAL)
+
+function(fast_startup target)
+    cmake_parse_arguments(F "" "STATIC;RELRO" "" ${ARGN})
+    if (NOT F_RELRO)
+        set(F_RELRO partial)
+    endif ()
+    if (NOT CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang" OR APPLE OR WIN32)
+        message(STATUS "fast_startup: ${target}: needs GCC or Clang and an "
+                       "ELF target, skipped")
+        return()
+    endif ()
+
+    set_target_properties(${target} PROPERTIES
+                          CXX_VISIBILITY_PRESET hidden
+                          VISIBILITY_INLINES_HIDDEN ON)
+    target_compile_options(${target} PRIVATE
+                           -fno-plt -ffunction-sections -fdata-sections)
+    target_link_options(${target} PRIVATE
+                        LINKER:-O1
+                        LINKER:--hash-style=gnu
+                        LINKER:--as-needed
+                        LINKER:--gc-sections
+                        LINKER:-Bsymbolic)
+    if (F_RELRO STREQUAL "full")
+        target_link_options(${target} PRIVATE LINKER:-z,relro LINKER:-z,now)
+    elseif (F_RELRO STREQUAL "partial")
+        target_link_options(${target} PRIVATE LINKER:-z,relro LINKER:-z,lazy)
+    elseif (F_RELRO STREQUAL "none")
+        target_link_options(${target} PRIVATE
+                            LINKER:-z,norelro LINKER:-z,lazy)
+    else ()
+        message(FATAL_ERROR "fast_startup: unknown RELRO ${F_RELRO}, expected "
+                            "full, partial or none")
+    endif ()
+    if (F_STATIC)
+        target_link_options(${target} PRIVATE -static)
+    endif ()
+endfunction()
+)cmake"};
+
+constexpr std::string_view kStartupLatencySource{R"tmpl(// Measures the time from spawning a program to its exit and compares the
+// median with a budget.
+//
+//   startup_latency [--runs N] [--warmup N] [--budget-us N] program [args...]
+//
+// The program runs with stdin, stdout and stderr on /dev/null and has to
+// exit with status 0.
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+extern char** environ;
+
+namespace {
+
+auto ParseCount(std::string_view text, long& value) -> bool {
+  const auto [end, ec] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  return ec == std::errc{} && end == text.data() + text.size() && value >= 0;
+}
+
+// Returns the elapsed time in microseconds, or a negative value when the
+// program couldn't be started or failed.
+auto RunOnce(char** argv) -> double {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                   O_RDONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                   O_WRONLY, 0);
+  const auto start = std::chrono::steady_clock::now();
+  pid_t pid{0};
+  const int rv = posix_spawn(&pid, argv[0], &actions, nullptr, argv, environ);
+  posix_spawn_file_actions_destroy(&actions);
+  if (rv != 0) {
+    std::fprintf(stderr, "startup_latency: failed to run %s: %s\n", argv[0],
+                 std::strerror(rv));
+    return -1.0;
+  }
+  int status{0};
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      std::perror("startup_latency: waitpid");
+      return -1.0;
+    }
+  }
+  const auto end = std::chrono::steady_clock::now();
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    std::fprintf(stderr, "startup_latency: %s failed with status %d\n",
+                 argv[0], status);
+    return -1.0;
+  }
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+auto Percentile(const std::vector<double>& sorted, double p) -> double {
+  const auto index = static_cast<std::size_t>(p * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  long runs{50};
+  long warmup{5};
+  long budget_us{0};
+  int i{1};
+  for (; i + 1 < argc; i += 2) {
+    const std::string_view option{argv[i]};
+    long* value{nullptr};
+    if (option == "--runs") {
+      value = &runs;
+    } else if (option == "--warmup") {
+      value = &warmup;
+    } else if (option == "--budget-us") {
+      value = &budget_us;
+    } else {
+      break;
+    }
+    if (!ParseCount(argv[i + 1], *value)) {
+      std::fprintf(stderr, "startup_latency: invalid %s: %s\n", argv[i],
+                   argv[i + 1]);
+      return EXIT_FAILURE;
+    }
+  }
+  if (i >= argc || runs == 0) {
+    std::fprintf(stderr,
+                 "usage: startup_latency [--runs N] [--warmup N] "
+                 "[--budget-us N] program [args...]\n");
+    return EXIT_FAILURE;
+  }
+
+  char** program = argv + i;
+  for (long run{0}; run < warmup; ++run) {
+    if (RunOnce(program) < 0) {
+      return EXIT_FAILURE;
+    }
+  }
+  std::vector<double> samples;
+  samples.reserve(static_cast<std::size_t>(runs));
+  for (long run{0}; run < runs; ++run) {
+    const auto elapsed = RunOnce(program);
+    if (elapsed < 0) {
+      return EXIT_FAILURE;
+    }
+    samples.push_back(elapsed);
+  }
+  std::sort(samples.begin(), samples.end());
+  const auto median = Percentile(samples, 0.5);
+  std::printf("%s: %ld runs, min %.0f us, median %.0f us, p90 %.0f us, "
+              "max %.0f us\n",
+              program[0], runs, samples.front(), median,
+              Percentile(samples, 0.9), samples.back());
+  if (budget_us > 0 && median > static_cast<double>(budget_us)) {
+    std::printf("median exceeds the budget of %ld us\n", budget_us);
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+)tmpl"};
+
+}  // namespace
+
+auto WriteFastStartupModule(const std::filesystem::path& project_path,
+                            const AppParams* param, BlobStore* store)
+    -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteFastStartupModule")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteFastStartupModule") << "param is a nullptr";
+    return 2;
+  }
+  const auto cmake_path = project_path / "cmake";
+  const auto bench_path = project_path / "bench";
+  for (const auto& dir : {cmake_path, bench_path}) {
+    std::error_code error_code;
+    std::filesystem::create_directories(dir, error_code);
+    if (error_code) {
+      Log(LogLevel::kError, "WriteFastStartupModule")
+          .Field("errno", error_code.value())
+          .Field("error", error_code.message())
+          << "failed to create directory: " << dir;
+      return 3;
+    }
+  }
+
+  const std::pair<std::filesystem::path, std::string_view> files[]{
+      {cmake_path / "fast_startup.cmake", kFastStartupCmake},
+      {bench_path / "startup_latency.cpp", kStartupLatencySource},
+  };
+  for (const auto& [path, text] : files) {
+    if (WriteSharedFile(path, text, store) != 0) {
+      Log(LogLevel::kError, "WriteFastStartupModule") << "failed to write "
+                                                      << path;
+      return 4;
+    }
+  }
+  return 0;
+}
+
+}  // namespace ci
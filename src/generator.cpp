@@ -2,22 +2,51 @@
 
 #include <algorithm>
 #include <fstream>
-#include <iostream>
+#include <sstream>
 #include <string_view>
 
+#include "cpp_init/allocator_module.h"
+#include "cpp_init/blob_store.h"
+#include "cpp_init/build_config_module.h"
+#include "cpp_init/concurrency_profile.h"
+#include "cpp_init/deps.h"
+#include "cpp_init/fast_startup_module.h"
+#include "cpp_init/instrumentation_module.h"
+#include "cpp_init/log.h"
+#include "cpp_init/resource_module.h"
+#include "cpp_init/service_profile.h"
+#include "cpp_init/template_scaffolding.h"
+#include "cpp_init/text_file.h"
+
 namespace ci {
 
+// Generates one project; GenerateProject reports its errors.
+auto GenerateProjectFiles(const std::filesystem::path& working_dir,
+                          CommonParams* param,
+                          const SuperProjectParams* parent, BlobStore* store)
+    -> int32_t;
+
 auto WriteProjectConfigCmake(const std::filesystem::path& cmake_path,
                              std::string_view name) -> uint8_t;
 
-auto WriteCmakeHelpers(const std::filesystem::path& cmake_path) -> uint8_t;
+auto WriteCmakeHelpers(const std::filesystem::path& cmake_path,
+                       BlobStore* store) -> uint8_t;
+auto WriteClangTidyCmake(const std::filesystem::path& cmake_path,
+                         BlobStore* store) -> uint8_t;
+auto WriteDepsCacheCmake(const std::filesystem::path& cmake_path,
+                         BlobStore* store) -> uint8_t;
+auto WriteClangTidyScript(const std::filesystem::path& cmake_path,
+                          BlobStore* store) -> uint8_t;
+auto WriteJobPoolsCmake(const std::filesystem::path& cmake_path,
+                        BlobStore* store) -> uint8_t;
 auto WriteClangFormat(const std::filesystem::path& project_path,
-                      bool has_parent) -> uint8_t;
-auto WriteClangTidy(const std::filesystem::path& project_path, bool has_parent)
-    -> uint8_t;
+                      bool has_parent, BlobStore* store) -> uint8_t;
+auto WriteClangTidy(const std::filesystem::path& project_path, bool has_parent,
+                    BlobStore* store) -> uint8_t;
 auto WriteAppNameHeader(const std::filesystem::path& project_path,
                         std::string_view ns) -> uint8_t;
-auto WriteSrcMain(const std::filesystem::path& src_path) -> uint8_t;
+auto WriteSrcMain(const std::filesystem::path& src_path, const AppParams* param)
+    -> uint8_t;
 auto WriteAppCMakeLists(const std::filesystem::path& project_path,
                         const AppParams* param,
                         const SuperProjectParams* parent) -> uint8_t;
@@ -29,23 +58,64 @@ auto WriteSuperCMakeLists(const std::filesystem::path& project_path,
 auto WriteLibraryTestCMakeLists(const std::filesystem::path& test_path,
                                 const LibraryParams* param) -> uint8_t;
 auto WriteLibraryTestSrcMain(const std::filesystem::path& test_src_path,
-                             const LibraryParams* param) -> uint8_t;
+                             const LibraryParams* param, BlobStore* store)
+    -> uint8_t;
+auto WriteLibrarySource(const std::filesystem::path& src_path,
+                        const LibraryParams* param) -> uint8_t;
+auto WriteObjectLibrary(std::ostream& out, const LibraryParams* param)
+    -> void;
+auto LibraryPublicHeaders(const LibraryParams* param)
+    -> std::vector<std::string>;
+auto LibraryPrivateSources(const LibraryParams* param)
+    -> std::vector<std::string>;
+auto LibraryPublicLibraries(const LibraryParams* param)
+    -> std::vector<std::string>;
+auto WriteTopLevelIncludes(std::ostream& out, const CommonParams* param)
+    -> void;
+auto WriteBuildConfigUsage(
+    std::ostream& out, const CommonParams* param,
+    const std::vector<std::string>& targets,
+    const std::vector<std::pair<std::string, std::string>>& switches) -> void;
+auto AppPrivateSources(const AppParams* param) -> std::vector<std::string>;
+auto AppPrivateLibraries(const AppParams* param) -> std::vector<std::string>;
 auto BuildTestOption(const CommonParams* param) -> std::string;
+auto BuildBenchmarkOption(const CommonParams* param) -> std::string;
 
 auto GenerateProject(const std::filesystem::path& working_dir,
-                     CommonParams* param, const SuperProjectParams* parent)
+                     CommonParams* param, const SuperProjectParams* parent,
+                     BlobStore* store) -> int32_t {
+  const auto code = GenerateProjectFiles(working_dir, param, parent, store);
+  if (code != 0 && param != nullptr) {
+    Log(LogLevel::kError, "GenerateProject")
+        .Field("project", param->name)
+        .Field("code", code)
+        << "failed to generate project";
+  }
+  return code;
+}
+
+auto GenerateProjectFiles(const std::filesystem::path& working_dir,
+                          CommonParams* param,
+                          const SuperProjectParams* parent, BlobStore* store)
     -> int32_t {
   int code{0};
   if (!is_directory(working_dir)) {
-    std::cerr << "GenerateProject: working directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "GenerateProject")
+        << "working directory doesn't exist";
     return 1;
   }
   if (!param) {
-    std::cerr << "GenerateProject: pointer to CommonParams is a nullptr."
-              << std::endl;
+    Log(LogLevel::kError, "GenerateProject")
+        << "pointer to CommonParams is a nullptr";
     return 2;
   }
+  if (const auto requested = param->cpp_standard; RaiseCppStandard(param)) {
+    Log(LogLevel::kWarning, "GenerateProject")
+        .Field("project", param->name)
+        .Field("requested", requested)
+        .Field("cxx_standard", param->cpp_standard)
+        << "raised the C++ standard to the one the selected features need";
+  }
 
   // Create project directories
   std::vector<std::filesystem::path> dirs;
@@ -94,9 +164,10 @@ auto GenerateProject(const std::filesystem::path& working_dir,
     if (!std::filesystem::exists(dir)) {
       std::error_code error_code;
       if (!std::filesystem::create_directories(dir, error_code)) {
-        std::cerr << "GenerateProject: failed to create directory: " << dir
-                  << "\n  Code: " << error_code.value()
-                  << "\n  Message: " << error_code.message() << std::endl;
+        Log(LogLevel::kError, "GenerateProject")
+            .Field("errno", error_code.value())
+            .Field("error", error_code.message())
+            << "failed to create directory: " << dir;
         return 3;
       }
     }
@@ -105,29 +176,39 @@ auto GenerateProject(const std::filesystem::path& working_dir,
   if (param->IsSuper() || !param->has_parent) {
     if (const auto rv = WriteProjectConfigCmake(cmake_path, param->name);
         rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
       return 4;
     }
 
-    if (const auto rv = WriteCmakeHelpers(cmake_path); rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
+    if (const auto rv = WriteCmakeHelpers(cmake_path, store); rv != 0) {
       return 5;
     }
+
+    if (const auto rv = WriteClangTidyCmake(cmake_path, store); rv != 0) {
+      return 14;
+    }
+
+    if (const auto rv = WriteClangTidyScript(cmake_path, store); rv != 0) {
+      return 15;
+    }
+
+    if (const auto rv = WriteDepsCacheCmake(cmake_path, store); rv != 0) {
+      return 18;
+    }
+
+    if (const auto rv = WriteJobPoolsCmake(cmake_path, store); rv != 0) {
+      return 21;
+    }
   }
 
-  if (const auto rv = WriteClangFormat(project_path, param->has_parent);
+  if (const auto rv =
+          WriteClangFormat(project_path, param->has_parent, store);
       rv != 0) {
-    std::cerr << "GenerateProject: failed to generate project " << param->name
-              << std::endl;
     return 6;
   }
 
-  if (const auto rv = WriteClangTidy(project_path, param->has_parent);
+  if (const auto rv =
+          WriteClangTidy(project_path, param->has_parent, store);
       rv != 0) {
-    std::cerr << "GenerateProject: failed to generate project " << param->name
-              << std::endl;
     return 7;
   }
 
@@ -136,40 +217,90 @@ auto GenerateProject(const std::filesystem::path& working_dir,
     if (const auto rv =
             WriteAppNameHeader(project_path, app_params->cpp_namespace);
         rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
       return 8;
     }
-    if (const auto rv = WriteSrcMain(src_path); rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
+    if (app_params->profile == AppProfile::kService) {
+      if (const auto rv = WriteServiceProfile(project_path, app_params);
+          rv != 0) {
+        return 16;
+      }
+    } else if (const auto rv = WriteSrcMain(src_path, app_params); rv != 0) {
       return 9;
     }
+    if (app_params->allocator_selection) {
+      if (const auto rv = WriteAllocatorModule(project_path, app_params);
+          rv != 0) {
+        return 20;
+      }
+    }
     if (const auto rv = WriteAppCMakeLists(project_path, app_params, parent); rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
       return 10;
     }
+    if (app_params->build_config) {
+      if (const auto rv = WriteBuildConfig(project_path, param->name,
+                                           app_params->cpp_namespace, store);
+          rv != 0) {
+        return 24;
+      }
+    }
+    if (app_params->embed_resources) {
+      if (const auto rv = WriteResourceModule(project_path, app_params, store);
+          rv != 0) {
+        return 25;
+      }
+    }
+    if (app_params->fast_startup) {
+      if (const auto rv =
+              WriteFastStartupModule(project_path, app_params, store);
+          rv != 0) {
+        return 26;
+      }
+    }
   }
   if (param->IsLibrary()) {
     const auto* lib_params = static_cast<const LibraryParams*>(param);
     if (const auto rv =
             WriteLibraryCMakeLists(project_path, lib_params, parent);
         rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
       return 11;
     }
+    if (lib_params->instrumentation) {
+      if (const auto rv = WriteInstrumentationModule(project_path, lib_params);
+          rv != 0) {
+        return 17;
+      }
+    }
+    if (lib_params->explicit_instantiation) {
+      if (const auto rv = WriteTemplateScaffolding(project_path, lib_params);
+          rv != 0) {
+        return 19;
+      }
+    }
+    if (lib_params->profile == LibraryProfile::kConcurrency) {
+      if (const auto rv = WriteConcurrencyProfile(project_path, lib_params);
+          rv != 0) {
+        return 23;
+      }
+    }
+    if (lib_params->object_library) {
+      if (const auto rv = WriteLibrarySource(src_path, lib_params); rv != 0) {
+        return 22;
+      }
+    }
+    if (lib_params->build_config) {
+      if (const auto rv = WriteBuildConfig(project_path, param->name,
+                                           lib_params->cpp_namespace, store);
+          rv != 0) {
+        return 24;
+      }
+    }
     if (const auto rv = WriteLibraryTestCMakeLists(test_path, lib_params);
         rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
       return 12;
     }
-    if (const auto rv = WriteLibraryTestSrcMain(test_src_path, lib_params);
+    if (const auto rv =
+            WriteLibraryTestSrcMain(test_src_path, lib_params, store);
         rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
       return 13;
     }
   }
@@ -177,8 +308,6 @@ auto GenerateProject(const std::filesystem::path& working_dir,
     const auto* super_params = static_cast<const SuperProjectParams*>(param);
     if (const auto rv = WriteSuperCMakeLists(project_path, super_params);
         rv != 0) {
-      std::cerr << "GenerateProject: failed to generate project " << param->name
-                << std::endl;
       return 12;
     }
   }
@@ -189,8 +318,8 @@ auto GenerateProject(const std::filesystem::path& working_dir,
 auto WriteProjectConfigCmake(const std::filesystem::path& cmake_path,
                              std::string_view name) -> uint8_t {
   if (!is_directory(cmake_path)) {
-    std::cerr << "WriteProjectConfigCmake: CMake directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteProjectConfigCmake")
+        << "CMake directory doesn't exist";
     return 1;
   }
   std::string tmp{name};
@@ -200,8 +329,8 @@ auto WriteProjectConfigCmake(const std::filesystem::path& cmake_path,
 
   std::ofstream out(cmake_file.string(), std::ios_base::out);
   if (!out.is_open()) {
-    std::cerr << "WriteProjectConfigCmake: failed to open " << cmake_file
-              << std::endl;
+    Log(LogLevel::kError, "WriteProjectConfigCmake") << "failed to open "
+                                                     << cmake_file;
     return 1;
   }
   out << R"(@PACKAGE_INIT@
@@ -214,28 +343,24 @@ if (NOT TARGET )";
   out << "-targets.cmake)\nendif()";
   out.close();
   if (out.is_open()) {
-    std::cerr << "WriteProjectConfigCmake: failed to close " << cmake_file
-              << std::endl;
+    Log(LogLevel::kError, "WriteProjectConfigCmake") << "failed to close "
+                                                     << cmake_file;
     return 1;
   }
   return 0;
 }
 
-auto WriteCmakeHelpers(const std::filesystem::path& cmake_path) -> uint8_t {
+auto WriteCmakeHelpers(const std::filesystem::path& cmake_path,
+                       BlobStore* store) -> uint8_t {
   if (!is_directory(cmake_path)) {
-    std::cerr << "WriteCmakeHelpers: CMake directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteCmakeHelpers")
+        << "CMake directory doesn't exist";
     return 1;
   }
   std::filesystem::path cmake_file{cmake_path};
   cmake_file.append("cmake_helpers.cmake");
 
-  std::ofstream out(cmake_file.string(), std::ios_base::out);
-  if (!out.is_open()) {
-    std::cerr << "WriteCmakeHelpers: failed to open " << cmake_file
-              << std::endl;
-    return 1;
-  }
+  std::ostringstream out;
   out << R"(include(FetchContent)
 
 FetchContent_Declare(
@@ -245,33 +370,346 @@ FetchContent_Declare(
 )
 FetchContent_MakeAvailable(ext_cmake_helpers)
 )";
-  out.close();
-  if (out.is_open()) {
-    std::cerr << "WriteCmakeHelpers: failed to close " << cmake_file
-              << std::endl;
+  if (WriteSharedFile(cmake_file, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteCmakeHelpers") << "failed to write "
+                                               << cmake_file;
     return 1;
   }
 
   return 0;
 }
+
+auto WriteClangTidyCmake(const std::filesystem::path& cmake_path,
+                         BlobStore* store) -> uint8_t {
+  if (!is_directory(cmake_path)) {
+    Log(LogLevel::kError, "WriteClangTidyCmake")
+        << "CMake directory doesn't exist";
+    return 1;
+  }
+  std::filesystem::path cmake_file{cmake_path};
+  cmake_file.append("clang_tidy.cmake");
+
+  std::ostringstream out;
+  out << R"(# Adds a `tidy` target that runs clang-tidy over compile_commands.json.
+# Translation units are checked in parallel and a successful result is cached
+# on a hash of the preprocessed source and the clang-tidy configuration, so
+# only changed files are checked again on the next run.
+set(CMAKE_EXPORT_COMPILE_COMMANDS ON)
+
+find_program(CLANG_TIDY_EXE NAMES clang-tidy)
+find_package(Python3 COMPONENTS Interpreter)
+
+cmake_host_system_information(RESULT CLANG_TIDY_DEFAULT_JOBS
+        QUERY NUMBER_OF_LOGICAL_CORES)
+set(CLANG_TIDY_JOBS ${CLANG_TIDY_DEFAULT_JOBS} CACHE STRING
+        "Number of clang-tidy processes run in parallel by the tidy target")
+set(CLANG_TIDY_CACHE_DIR ${CMAKE_BINARY_DIR}/clang-tidy-cache CACHE PATH
+        "Directory with the cached clang-tidy results")
+
+if (TARGET tidy)
+    return()
+endif ()
+if (NOT CLANG_TIDY_EXE OR NOT Python3_Interpreter_FOUND)
+    message(STATUS "clang-tidy or Python3 not found, tidy target is disabled")
+    return()
+endif ()
+
+add_custom_target(tidy
+        COMMAND ${Python3_EXECUTABLE} ${CMAKE_CURRENT_LIST_DIR}/run_clang_tidy.py
+            --clang-tidy ${CLANG_TIDY_EXE}
+            --build-dir ${CMAKE_BINARY_DIR}
+            --source-dir ${CMAKE_SOURCE_DIR}
+            --cache-dir ${CLANG_TIDY_CACHE_DIR}
+            --jobs ${CLANG_TIDY_JOBS}
+        WORKING_DIRECTORY ${CMAKE_BINARY_DIR}
+        COMMENT "Running clang-tidy"
+        USES_TERMINAL
+        VERBATIM
+)
+)";
+  if (WriteSharedFile(cmake_file, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteClangTidyCmake") << "failed to write "
+                                                 << cmake_file;
+    return 1;
+  }
+  return 0;
+}
+
+auto WriteClangTidyScript(const std::filesystem::path& cmake_path,
+                          BlobStore* store) -> uint8_t {
+  if (!is_directory(cmake_path)) {
+    Log(LogLevel::kError, "WriteClangTidyScript")
+        << "CMake directory doesn't exist";
+    return 1;
+  }
+  std::filesystem::path script_file{cmake_path};
+  script_file.append("run_clang_tidy.py");
+
+  std::ostringstream out;
+  out << R"py(#!/usr/bin/env python3
+"""Run clang-tidy in parallel over a compilation database.
+
+A translation unit is skipped when a previous run succeeded for the same
+preprocessed input, compile command, clang-tidy version and configuration.
+"""
+import argparse
+import concurrent.futures
+import hashlib
+import json
+import os
+import shlex
+import subprocess
+import sys
+
+# Compiler arguments that only affect the output or dependency files.
+DROP_FLAGS = {"-c", "-MD", "-MMD"}
+DROP_FLAGS_WITH_VALUE = {"-o", "-MF", "-MT", "-MQ"}
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--clang-tidy", default="clang-tidy")
+    parser.add_argument("--build-dir", required=True)
+    parser.add_argument("--source-dir", required=True)
+    parser.add_argument("--cache-dir", required=True)
+    parser.add_argument("--jobs", type=int, default=os.cpu_count() or 1)
+    return parser.parse_args()
+
+
+def command_of(entry):
+    if "arguments" in entry:
+        return list(entry["arguments"])
+    return shlex.split(entry["command"])
+
+
+def preprocess_command(command):
+    result = [command[0]]
+    skip = False
+    for arg in command[1:]:
+        if skip:
+            skip = False
+            continue
+        if arg in DROP_FLAGS:
+            continue
+        if arg in DROP_FLAGS_WITH_VALUE:
+            skip = True
+            continue
+        if arg.startswith("-o") and len(arg) > 2:
+            continue
+        result.append(arg)
+    result += ["-E", "-o", "-"]
+    return result
+
+
+def config_digest(directory, source_dir, cache):
+    """Hash of every .clang-tidy file from directory up to the source root."""
+    if directory in cache:
+        return cache[directory]
+    digest = hashlib.sha256()
+    path = os.path.join(directory, ".clang-tidy")
+    if os.path.isfile(path):
+        with open(path, "rb") as config:
+            digest.update(config.read())
+    parent = os.path.dirname(directory)
+    if directory != source_dir and parent != directory:
+        digest.update(config_digest(parent, source_dir, cache).encode())
+    cache[directory] = digest.hexdigest()
+    return cache[directory]
+
+
+def tidy_version(clang_tidy):
+    return subprocess.run([clang_tidy, "--version"], capture_output=True,
+                          check=False).stdout
+
+
+def check(entry, args, config, version):
+    source = os.path.normpath(os.path.join(entry["directory"], entry["file"]))
+    command = command_of(entry)
+    digest = hashlib.sha256()
+    digest.update(version)
+    digest.update(config.encode())
+    digest.update("\0".join(command).encode())
+    preprocessed = subprocess.run(preprocess_command(command),
+                                  cwd=entry["directory"], capture_output=True,
+                                  check=False)
+    key = None
+    if preprocessed.returncode == 0:
+        digest.update(preprocessed.stdout)
+        key = os.path.join(args.cache_dir, digest.hexdigest())
+        if os.path.exists(key):
+            return source, True, 0, b""
+    result = subprocess.run([args.clang_tidy, "-p", args.build_dir, "--quiet",
+                             source], capture_output=True, check=False)
+    if result.returncode == 0 and key is not None:
+        with open(key, "wb"):
+            pass
+    return source, False, result.returncode, result.stdout + result.stderr
+
+
+def main():
+    args = parse_args()
+    args.build_dir = os.path.abspath(args.build_dir)
+    args.source_dir = os.path.abspath(args.source_dir)
+    os.makedirs(args.cache_dir, exist_ok=True)
+    with open(os.path.join(args.build_dir, "compile_commands.json")) as db:
+        entries = json.load(db)
+
+    configs = {}
+    version = tidy_version(args.clang_tidy)
+    work = []
+    for entry in entries:
+        source = os.path.normpath(os.path.join(entry["directory"],
+                                               entry["file"]))
+        if not source.startswith(args.source_dir + os.sep):
+            continue
+        if source.startswith(args.build_dir + os.sep):
+            continue
+        config = config_digest(os.path.dirname(source), args.source_dir,
+                               configs)
+        work.append((entry, config))
+
+    cached = 0
+    failed = 0
+    with concurrent.futures.ThreadPoolExecutor(max(1, args.jobs)) as pool:
+        futures = [pool.submit(check, entry, args, config, version)
+                   for entry, config in work]
+        for future in concurrent.futures.as_completed(futures):
+            source, hit, code, output = future.result()
+            if hit:
+                cached += 1
+                continue
+            if output:
+                sys.stdout.write(output.decode(errors="replace"))
+            if code != 0:
+                failed += 1
+                print(f"clang-tidy failed: {source}")
+
+    print(f"clang-tidy: {len(work)} files, {cached} cached, {failed} failed")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
+)py";
+  if (WriteSharedFile(script_file, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteClangTidyScript") << "failed to write "
+                                                  << script_file;
+    return 1;
+  }
+  return 0;
+}
+
+auto WriteDepsCacheCmake(const std::filesystem::path& cmake_path,
+                         BlobStore* store) -> uint8_t {
+  if (!is_directory(cmake_path)) {
+    Log(LogLevel::kError, "WriteDepsCacheCmake")
+        << "CMake directory doesn't exist";
+    return 1;
+  }
+  std::filesystem::path cmake_file{cmake_path};
+  cmake_file.append("deps_cache.cmake");
+
+  std::ostringstream out;
+  out << DepsCacheCmake();
+  if (WriteSharedFile(cmake_file, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteDepsCacheCmake") << "failed to write "
+                                                 << cmake_file;
+    return 1;
+  }
+  return 0;
+}
+
+auto WriteJobPoolsCmake(const std::filesystem::path& cmake_path,
+                        BlobStore* store) -> uint8_t {
+  if (!is_directory(cmake_path)) {
+    Log(LogLevel::kError, "WriteJobPoolsCmake")
+        << "CMake directory doesn't exist";
+    return 1;
+  }
+  std::filesystem::path cmake_file{cmake_path};
+  cmake_file.append("job_pools.cmake");
+
+  std::ostringstream out;
+  out << R"cmake(# Ninja job pools for compiling and linking. The pool sizes are derived from
+# the available memory and the number of cores at configure time, so a build
+# with `ninja -j$(nproc)` uses the whole machine without running so many
+# compilers or (LTO) linkers in parallel that the machine runs out of memory.
+# Set COMPILE_JOB_POOL_SIZE or LINK_JOB_POOL_SIZE to override the derived
+# sizes. Other generators ignore the pools.
+include_guard(GLOBAL)
+
+set(COMPILE_JOB_MEMORY 1024 CACHE STRING
+        "Memory in MiB reserved for every compile job")
+set(LINK_JOB_MEMORY 4096 CACHE STRING
+        "Memory in MiB reserved for every link job")
+set(COMPILE_JOB_POOL_SIZE 0 CACHE STRING
+        "Number of parallel compile jobs, 0 derives it from memory and cores")
+set(LINK_JOB_POOL_SIZE 0 CACHE STRING
+        "Number of parallel link jobs, 0 derives it from memory and cores")
+
+cmake_host_system_information(RESULT _job_pools_cores
+        QUERY NUMBER_OF_LOGICAL_CORES)
+cmake_host_system_information(RESULT _job_pools_memory
+        QUERY AVAILABLE_PHYSICAL_MEMORY)
+
+# Number of jobs of the given size in MiB that fit in the available memory,
+# at least 1 and at most the number of cores.
+function(_job_pool_size result job_memory)
+    if (job_memory LESS 1)
+        set(job_memory 1)
+    endif ()
+    math(EXPR size "${_job_pools_memory} / ${job_memory}")
+    if (size GREATER _job_pools_cores)
+        set(size ${_job_pools_cores})
+    endif ()
+    if (size LESS 1)
+        set(size 1)
+    endif ()
+    set(${result} ${size} PARENT_SCOPE)
+endfunction()
+
+if (COMPILE_JOB_POOL_SIZE GREATER 0)
+    set(_compile_job_pool_size ${COMPILE_JOB_POOL_SIZE})
+else ()
+    _job_pool_size(_compile_job_pool_size ${COMPILE_JOB_MEMORY})
+endif ()
+if (LINK_JOB_POOL_SIZE GREATER 0)
+    set(_link_job_pool_size ${LINK_JOB_POOL_SIZE})
+else ()
+    _job_pool_size(_link_job_pool_size ${LINK_JOB_MEMORY})
+endif ()
+
+set_property(GLOBAL APPEND PROPERTY JOB_POOLS
+        compile_pool=${_compile_job_pool_size}
+        link_pool=${_link_job_pool_size})
+set(CMAKE_JOB_POOL_COMPILE compile_pool)
+set(CMAKE_JOB_POOL_LINK link_pool)
+message(STATUS "Job pools: ${_compile_job_pool_size} compile, "
+        "${_link_job_pool_size} link (${_job_pools_cores} cores, "
+        "${_job_pools_memory} MiB available)")
+)cmake";
+  if (WriteSharedFile(cmake_file, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteJobPoolsCmake") << "failed to write "
+                                                << cmake_file;
+    return 1;
+  }
+  return 0;
+}
+
 auto WriteClangFormat(const std::filesystem::path& project_path,
-                      bool has_parent) -> uint8_t {
+                      bool has_parent, BlobStore* store) -> uint8_t {
   if (has_parent) {
     return 0;
   }
   if (!is_directory(project_path)) {
-    std::cerr << "WriteClangFormat: project directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteClangFormat")
+        << "project directory doesn't exist";
     return 1;
   }
   std::filesystem::path clang_file{project_path};
   clang_file.append(".clang-format");
 
-  std::ofstream out(clang_file.string(), std::ios_base::out);
-  if (!out.is_open()) {
-    std::cerr << "WriteClangFormat: failed to open " << clang_file << std::endl;
-    return 1;
-  }
+  std::ostringstream out;
   out << R"(
 # Use the Google style in this project.
 BasedOnStyle: Google
@@ -286,30 +724,25 @@ PointerAlignment: Left
 # "const west" alignment of cv-qualifiers. In this project we use "const west".
 QualifierAlignment: Left
 )";
-  out.close();
-  if (out.is_open()) {
-    std::cerr << "WriteClangFormat: failed to close " << clang_file
-              << std::endl;
+  if (WriteSharedFile(clang_file, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteClangFormat") << "failed to write "
+                                              << clang_file;
     return 1;
   }
   return 0;
 }
 
-auto WriteClangTidy(const std::filesystem::path& project_path, bool has_parent)
-    -> uint8_t {
+auto WriteClangTidy(const std::filesystem::path& project_path, bool has_parent,
+                    BlobStore* store) -> uint8_t {
   if (!is_directory(project_path)) {
-    std::cerr << "WriteClangTidy: project directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteClangTidy")
+        << "project directory doesn't exist";
     return 1;
   }
   std::filesystem::path clang_file{project_path};
   clang_file.append(".clang-tidy");
 
-  std::ofstream out(clang_file.string(), std::ios_base::out);
-  if (!out.is_open()) {
-    std::cerr << "WriteClangTidy: failed to open " << clang_file << std::endl;
-    return 1;
-  }
+  std::ostringstream out;
   if (!has_parent) {
     out << R"(
 Checks: >
@@ -395,9 +828,8 @@ CheckOptions:
   } else {
     out << "InheritParentConfig: true\n";
   }
-  out.close();
-  if (out.is_open()) {
-    std::cerr << "WriteClangTidy: failed to close " << clang_file << std::endl;
+  if (WriteSharedFile(clang_file, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteClangTidy") << "failed to write " << clang_file;
     return 1;
   }
   return 0;
@@ -406,8 +838,8 @@ CheckOptions:
 auto WriteAppNameHeader(const std::filesystem::path& project_path,
                         std::string_view ns) -> uint8_t {
   if (!is_directory(project_path)) {
-    std::cerr << "WriteAppNameHeader: project directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteAppNameHeader")
+        << "project directory doesn't exist";
     return 1;
   }
   std::filesystem::path path{project_path};
@@ -415,22 +847,23 @@ auto WriteAppNameHeader(const std::filesystem::path& project_path,
 
   std::ofstream out(path.string(), std::ios_base::out);
   if (!out.is_open()) {
-    std::cerr << "WriteAppNameHeader: failed to open " << path << std::endl;
+    Log(LogLevel::kError, "WriteAppNameHeader") << "failed to open " << path;
     return 1;
   }
   out << "namespace " << ns << "{\n";
   out << "    const char* APP_NAME{\"@F_APP_NAME@\"};\n}\n";
   out.close();
   if (out.is_open()) {
-    std::cerr << "WriteAppNameHeader: failed to close " << path << std::endl;
+    Log(LogLevel::kError, "WriteAppNameHeader") << "failed to close " << path;
     return 1;
   }
   return 0;
 }
 
-auto WriteSrcMain(const std::filesystem::path& src_path) -> uint8_t {
+auto WriteSrcMain(const std::filesystem::path& src_path, const AppParams* param)
+    -> uint8_t {
   if (!is_directory(src_path)) {
-    std::cerr << "WriteSrcMain: source directory doesn't exist." << std::endl;
+    Log(LogLevel::kError, "WriteSrcMain") << "source directory doesn't exist";
     return 1;
   }
   std::filesystem::path path{src_path};
@@ -438,18 +871,27 @@ auto WriteSrcMain(const std::filesystem::path& src_path) -> uint8_t {
 
   std::ofstream out(path.string(), std::ios_base::out);
   if (!out.is_open()) {
-    std::cerr << "WriteSrcMain: failed to open " << path << std::endl;
+    Log(LogLevel::kError, "WriteSrcMain") << "failed to open " << path;
     return 1;
   }
-  out << R"(#include <iostream>
+  if (param != nullptr && param->allocator_selection) {
+    out << "#include <cstdlib>\n\n";
+    out << "#include \"" << param->name << "/allocator_stats.h\"\n\n";
+    out << "int main(int argc, char** argv) {\n";
+    out << "  " << param->cpp_namespace
+        << "::allocator::DumpStatsAtExit();\n";
+    out << "  return EXIT_SUCCESS;\n}\n";
+  } else {
+    out << R"(#include <iostream>
 
 int main(int argc, char** argv) {
   return EXIT_SUCCESS;
 }
 )";
+  }
   out.close();
   if (out.is_open()) {
-    std::cerr << "WriteSrcMain: failed to close " << path << std::endl;
+    Log(LogLevel::kError, "WriteSrcMain") << "failed to close " << path;
     return 1;
   }
   return 0;
@@ -458,16 +900,16 @@ int main(int argc, char** argv) {
 auto WriteAppCMakeLists(const std::filesystem::path& project_path,
                         const AppParams* param, const SuperProjectParams* parent) -> uint8_t {
   if (!is_directory(project_path)) {
-    std::cerr << "WriteAppCMakeLists: source directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteAppCMakeLists")
+        << "source directory doesn't exist";
     return 1;
   }
   if (param == nullptr) {
-    std::cerr << "WriteAppCMakeLists: param is a nullptr" << std::endl;
+    Log(LogLevel::kError, "WriteAppCMakeLists") << "param is a nullptr";
     return 2;
   }
  if (param->has_parent && parent == nullptr) {
-    std::cerr << "WriteLibraryCMakeLists: parent is a nullptr" << std::endl;
+    Log(LogLevel::kError, "WriteLibraryCMakeLists") << "parent is a nullptr";
     return 3;
   }
 
@@ -483,7 +925,7 @@ auto WriteAppCMakeLists(const std::filesystem::path& project_path,
 
   std::ofstream out(path.string(), std::ios_base::out);
   if (!out.is_open()) {
-    std::cerr << "WriteAppCMakeLists: failed to open " << path << std::endl;
+    Log(LogLevel::kError, "WriteAppCMakeLists") << "failed to open " << path;
     return 4;
   }
   if (!param->has_parent) {
@@ -495,7 +937,7 @@ auto WriteAppCMakeLists(const std::filesystem::path& project_path,
   out << "        )\n\n";
 
   if (!param->has_parent) {
-    out << "include(cmake/cmake_helpers.cmake)\n\n";
+    WriteTopLevelIncludes(out, param);
   }
 
   if(!param->has_parent) {
@@ -504,6 +946,21 @@ auto WriteAppCMakeLists(const std::filesystem::path& project_path,
   }
 
 
+  const bool is_service{param->profile == AppProfile::kService};
+  if (is_service) {
+    out << "find_package(Threads REQUIRED)\n";
+    out << "find_package(PkgConfig)\n";
+    out << "option(" << ToUpperIdentifier(param->name)
+        << "_USE_IO_URING \"Use io_uring when liburing is available\" ON)\n";
+    out << "if (" << ToUpperIdentifier(param->name)
+        << "_USE_IO_URING AND PkgConfig_FOUND)\n";
+    out << "    pkg_check_modules(LIBURING IMPORTED_TARGET liburing)\n";
+    out << "endif ()\n\n";
+  }
+  if (param->allocator_selection) {
+    out << "include(cmake/allocator.cmake)\n\n";
+  }
+
   out << "add_app(\n";
   out << "        APP_NAME " << param->name << '\n';
   out << "        APP_CMAKE_NAMESPACE " << param->cmake_namespace << '\n';
@@ -511,17 +968,116 @@ auto WriteAppCMakeLists(const std::filesystem::path& project_path,
   out << "        APP_OUTPUT_NAME " << param->output_name << '\n';
   out << "        APP_VERSION ${PROJECT_VERSION}\n";
   out << "        APP_PRIVATE_INCLUDE_DIR\n            " << param->name << '\n';
-  out << "        APP_PRIVATE_SOURCES\n            src/main.cpp\n";
+  out << "        APP_PRIVATE_SOURCES\n";
+  for (const auto& source : AppPrivateSources(param)) {
+    out << "            " << source << '\n';
+  }
   out << "        # APP_PUBLIC_SOURCES\n";
   out << "        # APP_PUBLIC_LIBRARIES\n";
-  out << "        # APP_PRIVATE_LIBRARIES\n";
+  if (const auto libraries = AppPrivateLibraries(param); libraries.empty()) {
+    out << "        # APP_PRIVATE_LIBRARIES\n";
+  } else {
+    out << "        APP_PRIVATE_LIBRARIES\n";
+    for (const auto& library : libraries) {
+      out << "            " << library << '\n';
+    }
+  }
   out << "        # APP_PRIVATE_HEADERS\n";
   out << "        # APP_DEPENDENCIES\n";
   out << ")\n";
 
+  if (is_service || param->allocator_selection) {
+    out << "target_include_directories(" << param->name
+        << " PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/include)\n";
+  }
+  const auto bench_option = BuildBenchmarkOption(param);
+  if (is_service) {
+    out << "if (LIBURING_FOUND)\n";
+    out << "    target_compile_definitions(" << param->name
+        << " PRIVATE HAVE_LIBURING)\n";
+    out << "    target_link_libraries(" << param->name
+        << " PRIVATE PkgConfig::LIBURING)\n";
+    out << "endif ()\n\n";
+    out << "option(" << bench_option << " \"Build project benchmarks\" ON)\n";
+    out << "if (${" << bench_option << "})\n";
+    out << "    add_executable(" << param->name << "_loadgen bench/loadgen.cpp)\n";
+    out << "    target_compile_features(" << param->name
+        << "_loadgen PRIVATE cxx_std_17)\n";
+    out << "    target_link_libraries(" << param->name
+        << "_loadgen PRIVATE Threads::Threads)\n";
+    out << "endif ()\n";
+  }
+  if (param->allocator_selection) {
+    const auto bench = param->name + "_alloc_bench";
+    if (!is_service) {
+      out << "\noption(" << bench_option
+          << " \"Build project benchmarks\" ON)\n";
+    }
+    out << "if (${" << bench_option << "})\n";
+    out << "    find_package(Threads REQUIRED)\n";
+    out << "    add_executable(" << bench
+        << " bench/alloc_bench.cpp src/allocator_stats.cpp)\n";
+    out << "    target_include_directories(" << bench
+        << " PRIVATE ${CMAKE_CURRENT_SOURCE_DIR}/include)\n";
+    out << "    target_compile_features(" << bench << " PRIVATE cxx_std_17)\n";
+    out << "    target_link_libraries(" << bench << " PRIVATE "
+        << param->name << "_allocator Threads::Threads)\n";
+    out << "endif ()\n";
+  }
+  if (param->build_config) {
+    std::vector<std::pair<std::string, std::string>> switches;
+    if (is_service) {
+      switches.emplace_back("IO_URING", "${LIBURING_FOUND}");
+    }
+    if (param->allocator_selection) {
+      switches.emplace_back(
+          "ALLOCATOR_STATS",
+          "${" + ToUpperIdentifier(param->name) + "_ALLOCATOR_STATS}");
+    }
+    WriteBuildConfigUsage(out, param, {param->name}, switches);
+  }
+  if (param->embed_resources) {
+    out << "\ninclude(cmake/resources.cmake)\n";
+    out << "embed_resources(" << param->name << " NAME " << param->name
+        << " DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}/resources)\n";
+  }
+  if (param->fast_startup) {
+    const auto upper_name = ToUpperIdentifier(param->name);
+    out << "\ninclude(cmake/fast_startup.cmake)\n";
+    out << "set(" << upper_name << "_RELRO partial CACHE STRING\n"
+        << "    \"RELRO mode of " << param->name
+        << ": full, partial or none\")\n";
+    out << "set_property(CACHE " << upper_name
+        << "_RELRO PROPERTY STRINGS full partial none)\n";
+    out << "option(" << upper_name << "_STATIC \"Link " << param->name
+        << " statically\" OFF)\n";
+    out << "fast_startup(" << param->name << " STATIC ${" << upper_name
+        << "_STATIC} RELRO ${" << upper_name << "_RELRO})\n";
+    // A service runs until it is signalled, so only the startup of the
+    // other profiles is measured.
+    if (!is_service) {
+      const auto bench = param->name + "_startup_latency";
+      out << "set(" << upper_name << "_STARTUP_BUDGET_US 5000 CACHE STRING\n"
+          << "    \"Median exec-to-exit time of " << param->name
+          << " allowed by the " << bench << " test\")\n";
+      out << "if (${" << test_option << "})\n";
+      out << "    enable_testing()\n";
+      out << "    add_executable(" << bench << " bench/startup_latency.cpp)\n";
+      out << "    target_compile_features(" << bench
+          << " PRIVATE cxx_std_17)\n";
+      out << "    add_test(NAME " << bench << "\n";
+      out << "             COMMAND " << bench << " --budget-us ${"
+          << upper_name << "_STARTUP_BUDGET_US}\n";
+      out << "                     $<TARGET_FILE:" << param->name << ">)\n";
+      out << "    set_tests_properties(" << bench
+          << " PROPERTIES TIMEOUT 120)\n";
+      out << "endif ()\n";
+    }
+  }
+
   out.close();
   if (out.is_open()) {
-    std::cerr << "WriteAppCMakeLists: failed to close " << path << std::endl;
+    Log(LogLevel::kError, "WriteAppCMakeLists") << "failed to close " << path;
     return 4;
   }
   return 0;
@@ -531,16 +1087,16 @@ auto WriteLibraryCMakeLists(const std::filesystem::path& project_path,
                             const LibraryParams* param,
                             const SuperProjectParams* parent) -> uint8_t {
   if (!is_directory(project_path)) {
-    std::cerr << "WriteLibraryCMakeLists: project directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteLibraryCMakeLists")
+        << "project directory doesn't exist";
     return 1;
   }
   if (param == nullptr) {
-    std::cerr << "WriteLibraryCMakeLists: param is a nullptr" << std::endl;
+    Log(LogLevel::kError, "WriteLibraryCMakeLists") << "param is a nullptr";
     return 2;
   }
   if (param->has_parent && parent == nullptr) {
-    std::cerr << "WriteLibraryCMakeLists: parent is a nullptr" << std::endl;
+    Log(LogLevel::kError, "WriteLibraryCMakeLists") << "parent is a nullptr";
     return 3;
   }
   std::filesystem::path path{project_path};
@@ -555,7 +1111,8 @@ auto WriteLibraryCMakeLists(const std::filesystem::path& project_path,
 
   std::ofstream out(path.string(), std::ios_base::out);
   if (!out.is_open()) {
-    std::cerr << "WriteLibraryCMakeLists: failed to open " << path << std::endl;
+    Log(LogLevel::kError, "WriteLibraryCMakeLists")
+        << "failed to open " << path;
     return 4;
   }
 
@@ -568,7 +1125,7 @@ auto WriteLibraryCMakeLists(const std::filesystem::path& project_path,
   out << "        )\n\n";
 
   if (!param->has_parent) {
-    out << "include(cmake/cmake_helpers.cmake)\n\n";
+    WriteTopLevelIncludes(out, param);
   }
 
   if(!param->has_parent) {
@@ -576,24 +1133,149 @@ auto WriteLibraryCMakeLists(const std::filesystem::path& project_path,
       << " \"Build project tests\" ON)\n\n";
   }
 
+  const auto upper_name = ToUpperIdentifier(param->name);
+  const bool is_concurrency{param->profile == LibraryProfile::kConcurrency};
+  if (is_concurrency) {
+    out << "find_package(Threads REQUIRED)\n";
+    out << "option(" << upper_name << "_ENABLE_TSAN\n"
+        << "       \"Build the library and its tests with ThreadSanitizer\" "
+           "OFF)\n";
+    out << '\n';
+  }
+  if (param->instrumentation) {
+    out << "option(" << upper_name << "_ENABLE_INSTRUMENTATION\n"
+        << "       \"Compile in timers, hardware counters and trace events\" "
+           "OFF)\n\n";
+  }
+
+  const auto public_headers = LibraryPublicHeaders(param);
+  auto private_sources = LibraryPrivateSources(param);
+  if (param->object_library) {
+    WriteObjectLibrary(out, param);
+    private_sources = {"$<TARGET_OBJECTS:" + param->name + "_objects>"};
+  }
   out << "add_lib(\n";
   out << "        LIB_NAME " << param->name << "\n";
   out << "        LIB_CMAKE_NAMESPACE " << param->cmake_namespace << "\n";
   out << "        CXX_STANDARD " << static_cast<uint32_t>(param->cpp_standard) << '\n';
   out << "        LIB_ALIAS_NAME " << param->alias << "\n";
   out << "        LIB_VERSION ${PROJECT_VERSION}\n";
-  out << "        # LIB_PUBLIC_HEADERS\n";
-  out << "        # LIB_PRIVATE_SOURCES\n";
-  out << "        # LIB_PUBLIC_LIBRARIES\n";
+  if (public_headers.empty()) {
+    out << "        # LIB_PUBLIC_HEADERS\n";
+  } else {
+    out << "        LIB_PUBLIC_HEADERS\n";
+    for (const auto& header : public_headers) {
+      out << "            " << header << '\n';
+    }
+  }
+  if (private_sources.empty()) {
+    out << "        # LIB_PRIVATE_SOURCES\n";
+  } else {
+    out << "        LIB_PRIVATE_SOURCES\n";
+    for (const auto& source : private_sources) {
+      out << "            " << source << '\n';
+    }
+  }
+  if (const auto libraries = LibraryPublicLibraries(param);
+      libraries.empty()) {
+    out << "        # LIB_PUBLIC_LIBRARIES\n";
+  } else {
+    out << "        LIB_PUBLIC_LIBRARIES\n";
+    for (const auto& library : libraries) {
+      out << "            " << library << '\n';
+    }
+  }
   out << "        # LIB_PRIVATE_LIBRARIES\n";
   out << "        # LIB_PRIVATE_HEADERS\n";
   out << ")\n";
+  if (param->explicit_instantiation) {
+    out << "\ninclude(cmake/public_header_check.cmake)\n";
+    out << "check_public_headers(\n";
+    out << "        INCLUDE_DIR ${CMAKE_CURRENT_SOURCE_DIR}/include\n";
+    out << "        HEADERS\n";
+    out << "            include/" << param->name << '/' << param->name
+        << "_fwd.h\n";
+    out << "            include/" << param->name << '/' << param->name
+        << ".h\n";
+    out << "        ALLOWED\n";
+    for (const auto header : PublicHeaderAllowlist()) {
+      out << "            " << header << '\n';
+    }
+    out << ")\n";
+  }
+  if (param->instrumentation) {
+    out << "if (" << upper_name << "_ENABLE_INSTRUMENTATION)\n";
+    out << "    target_compile_definitions(" << param->name << " PUBLIC "
+        << upper_name << "_ENABLE_INSTRUMENTATION=1)\n";
+    if (param->object_library) {
+      out << "    target_compile_definitions(" << param->name
+          << "_objects PUBLIC " << upper_name
+          << "_ENABLE_INSTRUMENTATION=1)\n";
+    }
+    out << "endif ()\n";
+  }
+  if (is_concurrency) {
+    // On the targets, so consumers in other directories, such as the
+    // applications of a super project, are instrumented and linked against
+    // the TSan runtime as well.
+    std::vector<std::string> targets{param->name};
+    if (param->object_library) {
+      targets.push_back(param->name + "_objects");
+    }
+    out << "if (" << upper_name << "_ENABLE_TSAN)\n";
+    for (const auto& target : targets) {
+      out << "    target_compile_options(" << target
+          << " PUBLIC -fsanitize=thread -g)\n";
+      out << "    target_link_options(" << target
+          << " INTERFACE -fsanitize=thread)\n";
+    }
+    out << "endif ()\n";
+  }
+  if (param->object_library) {
+    out << "option(" << upper_name << "_SHARED_VARIANT\n"
+        << "       \"Also link " << param->name
+        << "_shared from the objects of " << param->name << "\" OFF)\n";
+    out << "if (" << upper_name << "_SHARED_VARIANT)\n";
+    out << "    add_library(" << param->name << "_shared SHARED)\n";
+    out << "    target_link_libraries(" << param->name << "_shared PUBLIC "
+        << param->name << "_objects)\n";
+    out << "    set_target_properties(" << param->name
+        << "_shared PROPERTIES OUTPUT_NAME " << param->name << ")\n";
+    out << "endif ()\n";
+  }
+  if (is_concurrency) {
+    const auto bench_option = BuildBenchmarkOption(param);
+    const auto bench = param->name + "_bench";
+    out << "option(" << bench_option << " \"Build project benchmarks\" ON)\n";
+    out << "if (${" << bench_option << "})\n";
+    out << "    add_executable(" << bench << " bench/throughput.cpp)\n";
+    out << "    target_compile_features(" << bench << " PRIVATE cxx_std_17)\n";
+    out << "    target_link_libraries(" << bench << " PRIVATE "
+        << (param->object_library ? param->name + "_objects" : param->name)
+        << ")\n";
+    out << "endif ()\n";
+  }
+  if (param->build_config) {
+    std::vector<std::string> targets{param->name};
+    if (param->object_library) {
+      targets.push_back(param->name + "_objects");
+    }
+    std::vector<std::pair<std::string, std::string>> switches;
+    if (param->instrumentation) {
+      switches.emplace_back("INSTRUMENTATION",
+                            "${" + upper_name + "_ENABLE_INSTRUMENTATION}");
+    }
+    if (is_concurrency) {
+      switches.emplace_back("TSAN", "${" + upper_name + "_ENABLE_TSAN}");
+    }
+    WriteBuildConfigUsage(out, param, targets, switches);
+  }
   out << "if (${" << test_option << "})\n";
   out << "    add_subdirectory(tests)\nendif ()\n";
   out.close();
   if (out.is_open()) {
-    std::cerr << "WriteLibraryCMakeLists: failed to close " << path
-              << std::endl;
+    Log(LogLevel::kError, "WriteLibraryCMakeLists") << "failed to close "
+                                                    << path;
     return 4;
   }
   return 0;
@@ -602,20 +1284,20 @@ auto WriteLibraryCMakeLists(const std::filesystem::path& project_path,
 auto WriteLibraryTestCMakeLists(const std::filesystem::path& test_path,
                                 const LibraryParams* param) -> uint8_t {
   if (!is_directory(test_path)) {
-    std::cerr << "WriteLibraryTestCMakeLists: tests directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteLibraryTestCMakeLists")
+        << "tests directory doesn't exist";
     return 1;
   }
   if (param == nullptr) {
-    std::cerr << "WriteLibraryTestCMakeLists: param is a nullptr" << std::endl;
+    Log(LogLevel::kError, "WriteLibraryTestCMakeLists") << "param is a nullptr";
     return 2;
   }
   std::filesystem::path path{test_path};
   path.append("CMakeLists.txt");
   std::ofstream out(path.string(), std::ios_base::out);
   if (!out.is_open()) {
-    std::cerr << "WriteLibraryTestCMakeLists: failed to open " << path
-              << std::endl;
+    Log(LogLevel::kError, "WriteLibraryTestCMakeLists") << "failed to open "
+                                                        << path;
     return 3;
   }
 
@@ -628,15 +1310,24 @@ auto WriteLibraryTestCMakeLists(const std::filesystem::path& test_path,
       << '\n';
   out << "        APP_PRIVATE_SOURCES\n";
   out << "            src/main.cpp\n";
+  if (param->profile == LibraryProfile::kConcurrency) {
+    out << "            src/concurrency_tests.cpp\n";
+  }
   out << "        APP_PRIVATE_LIBRARIES\n";
-  out << "            " << param->cmake_namespace << "::" << param->alias
-      << '\n';
+  if (param->object_library) {
+    // Links the objects instead of the archive, so the tests also see
+    // symbols that aren't exported.
+    out << "            " << param->name << "_objects\n";
+  } else {
+    out << "            " << param->cmake_namespace << "::" << param->alias
+        << '\n';
+  }
   out << "            Catch2::Catch2\n";
   out << ")\n";
   out.close();
   if (out.is_open()) {
-    std::cerr << "WriteLibraryTestCMakeLists: failed to close " << path
-              << std::endl;
+    Log(LogLevel::kError, "WriteLibraryTestCMakeLists") << "failed to close "
+                                                        << path;
     return 4;
   }
   return 0;
@@ -645,19 +1336,19 @@ auto WriteLibraryTestCMakeLists(const std::filesystem::path& test_path,
 auto WriteSuperCMakeLists(const std::filesystem::path& project_path,
                           const SuperProjectParams* param) -> uint8_t {
   if (!is_directory(project_path)) {
-    std::cerr << "WriteSuperCMakeLists: project directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteSuperCMakeLists")
+        << "project directory doesn't exist";
     return 1;
   }
   if (param == nullptr) {
-    std::cerr << "WriteSuperCMakeLists: param is a nullptr" << std::endl;
+    Log(LogLevel::kError, "WriteSuperCMakeLists") << "param is a nullptr";
     return 2;
   }
   std::filesystem::path path{project_path};
   path.append("CMakeLists.txt");
   std::ofstream out(path.string(), std::ios_base::out);
   if (!out.is_open()) {
-    std::cerr << "WriteSuperCMakeLists: failed to open " << path << std::endl;
+    Log(LogLevel::kError, "WriteSuperCMakeLists") << "failed to open " << path;
     return 3;
   }
   out << "cmake_minimum_required(VERSION ${CMAKE_VERSION})\n\n";
@@ -666,9 +1357,11 @@ auto WriteSuperCMakeLists(const std::filesystem::path& project_path,
   out << "        VERSION 0.0.1\n";
   out << "        )\n\n";
 
-  out << "include(cmake/cmake_helpers.cmake)\n\n";
+  WriteTopLevelIncludes(out, param);
   out << "option(" << BuildTestOption(param)
-      << " \"Build project tests\" ON)\n\n";
+      << " \"Build project tests\" ON)\n";
+  out << "if (${" << BuildTestOption(param) << "})\n";
+  out << "    enable_testing()\nendif ()\n\n";
 
   for (const auto& dir_name : param->sub_projects) {
     out << "add_subdirectory(" << dir_name << ")\n";
@@ -676,31 +1369,27 @@ auto WriteSuperCMakeLists(const std::filesystem::path& project_path,
 
   out.close();
   if (out.is_open()) {
-    std::cerr << "WriteSuperCMakeLists: failed to close " << path << std::endl;
+    Log(LogLevel::kError, "WriteSuperCMakeLists") << "failed to close " << path;
     return 4;
   }
   return 0;
 }
 
 auto WriteLibraryTestSrcMain(const std::filesystem::path& test_src_path,
-                             const LibraryParams* param) -> uint8_t {
+                             const LibraryParams* param, BlobStore* store)
+    -> uint8_t {
   if (!is_directory(test_src_path)) {
-    std::cerr << "WriteLibraryTestSrcMain: tests src directory doesn't exist."
-              << std::endl;
+    Log(LogLevel::kError, "WriteLibraryTestSrcMain")
+        << "tests src directory doesn't exist";
     return 1;
   }
   if (param == nullptr) {
-    std::cerr << "WriteLibraryTestSrcMain: param is a nullptr" << std::endl;
+    Log(LogLevel::kError, "WriteLibraryTestSrcMain") << "param is a nullptr";
     return 2;
   }
   std::filesystem::path path{test_src_path};
   path.append("main.cpp");
-  std::ofstream out(path.string(), std::ios_base::out);
-  if (!out.is_open()) {
-    std::cerr << "WriteLibraryTestSrcMain: failed to open " << path
-              << std::endl;
-    return 3;
-  }
+  std::ostringstream out;
   out << R"(#include <catch2/catch_session.hpp>
 
 auto main(int argc, char* argv[]) -> int {
@@ -726,14 +1415,188 @@ auto main(int argc, char* argv[]) -> int {
   return numFailed;
 }
 )";
-  out.close();
-  if (out.is_open()) {
-    std::cerr << "WriteLibraryTestSrcMain: failed to close " << path
-              << std::endl;
+  if (WriteSharedFile(path, out.str(), store) != 0) {
+    Log(LogLevel::kError, "WriteLibraryTestSrcMain") << "failed to write "
+                                                     << path;
     return 4;
   }
   return 0;
 }
+
+auto WriteLibrarySource(const std::filesystem::path& src_path,
+                        const LibraryParams* param) -> uint8_t {
+  if (!is_directory(src_path)) {
+    Log(LogLevel::kError, "WriteLibrarySource")
+        << "source directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteLibrarySource") << "param is a nullptr";
+    return 2;
+  }
+  const auto path = src_path / (param->name + ".cpp");
+  const auto content = "// Compiled once into " + param->name +
+                       "_objects, which is linked into\n// " + param->name +
+                       ", " + param->name + "_shared and " + param->name +
+                       "_tests.\n\nnamespace " + param->cpp_namespace +
+                       " {}  // namespace " + param->cpp_namespace + "\n";
+  if (WriteTextFile(path, content) != 0) {
+    Log(LogLevel::kError, "WriteLibrarySource") << "failed to write " << path;
+    return 3;
+  }
+  return 0;
+}
+
+auto WriteObjectLibrary(std::ostream& out, const LibraryParams* param)
+    -> void {
+  const auto objects = param->name + "_objects";
+  out << "# The sources are compiled once; the library, the shared variant and "
+         "the tests\n# link these objects.\n";
+  out << "add_library(" << objects << " OBJECT\n";
+  for (const auto& source : LibraryPrivateSources(param)) {
+    out << "        " << source << '\n';
+  }
+  out << ")\n";
+  out << "set_target_properties(" << objects
+      << " PROPERTIES POSITION_INDEPENDENT_CODE ON)\n";
+  out << "target_compile_features(" << objects << " PUBLIC cxx_std_"
+      << static_cast<uint32_t>(param->cpp_standard) << ")\n";
+  out << "target_include_directories(" << objects
+      << " PUBLIC $<BUILD_INTERFACE:${CMAKE_CURRENT_SOURCE_DIR}/include>)\n";
+  if (const auto libraries = LibraryPublicLibraries(param);
+      !libraries.empty()) {
+    out << "target_link_libraries(" << objects << " PUBLIC";
+    for (const auto& library : libraries) {
+      out << ' ' << library;
+    }
+    out << ")\n";
+  }
+  out << '\n';
+}
+
+auto WriteBuildConfigUsage(
+    std::ostream& out, const CommonParams* param,
+    const std::vector<std::string>& targets,
+    const std::vector<std::pair<std::string, std::string>>& switches) -> void {
+  out << "\ninclude(cmake/build_config.cmake)\n";
+  out << "build_config(" << param->name;
+  for (const auto& target : targets) {
+    out << ' ' << target;
+  }
+  out << ")\n";
+  for (const auto& [name, value] : switches) {
+    out << "build_config_switch(" << param->name << ' ' << name << " \""
+        << value << "\")\n";
+  }
+  out << '\n';
+}
+
+auto WriteTopLevelIncludes(std::ostream& out, const CommonParams* param)
+    -> void {
+  out << "set(CPP_INIT_DEPS_CXX_STANDARD "
+      << static_cast<uint32_t>(param->cpp_standard) << ")\n";
+  out << "include(cmake/deps_cache.cmake)\n";
+  out << "include(cmake/cmake_helpers.cmake)\n";
+  out << "include(cmake/clang_tidy.cmake)\n";
+  out << "include(cmake/job_pools.cmake)\n\n";
+}
+
+auto LibraryPublicHeaders(const LibraryParams* param)
+    -> std::vector<std::string> {
+  std::vector<std::string> headers;
+  if (param == nullptr) {
+    return headers;
+  }
+  const auto dir = "include/" + param->name + "/";
+  if (param->profile == LibraryProfile::kConcurrency) {
+    headers.push_back(dir + "cache_line.h");
+    headers.push_back(dir + "spsc_ring.h");
+    headers.push_back(dir + "mpmc_ring.h");
+    headers.push_back(dir + "work_stealing_deque.h");
+    headers.push_back(dir + "thread_pool.h");
+  }
+  if (param->explicit_instantiation) {
+    headers.push_back(dir + param->name + "_fwd.h");
+    headers.push_back(dir + param->name + ".h");
+    headers.push_back(dir + param->name + "_impl.h");
+  }
+  if (param->instrumentation) {
+    headers.push_back(dir + "instrumentation.h");
+  }
+  headers.insert(headers.end(), param->headers.cbegin(), param->headers.cend());
+  return headers;
+}
+
+auto LibraryPrivateSources(const LibraryParams* param)
+    -> std::vector<std::string> {
+  std::vector<std::string> sources;
+  if (param == nullptr) {
+    return sources;
+  }
+  if (param->profile == LibraryProfile::kConcurrency) {
+    sources.emplace_back("src/thread_pool.cpp");
+  }
+  if (param->explicit_instantiation) {
+    sources.emplace_back("src/instantiations.cpp");
+  }
+  if (param->instrumentation) {
+    sources.emplace_back("src/instrumentation.cpp");
+  }
+  if (param->object_library) {
+    sources.push_back("src/" + param->name + ".cpp");
+  }
+  sources.insert(sources.end(), param->sources.cbegin(), param->sources.cend());
+  return sources;
+}
+
+auto LibraryPublicLibraries(const LibraryParams* param)
+    -> std::vector<std::string> {
+  std::vector<std::string> libraries;
+  if (param == nullptr) {
+    return libraries;
+  }
+  if (param->profile == LibraryProfile::kConcurrency) {
+    libraries.emplace_back("Threads::Threads");
+  }
+  libraries.insert(libraries.end(), param->libraries.cbegin(),
+                   param->libraries.cend());
+  return libraries;
+}
+
+auto AppPrivateSources(const AppParams* param) -> std::vector<std::string> {
+  std::vector<std::string> sources;
+  if (param == nullptr) {
+    return sources;
+  }
+  sources.emplace_back("src/main.cpp");
+  if (param->profile == AppProfile::kService) {
+    sources.emplace_back("src/server.cpp");
+    sources.emplace_back("src/event_loop_epoll.cpp");
+    sources.emplace_back("src/event_loop_uring.cpp");
+  }
+  if (param->allocator_selection) {
+    sources.emplace_back("src/allocator_stats.cpp");
+  }
+  sources.insert(sources.end(), param->sources.cbegin(), param->sources.cend());
+  return sources;
+}
+
+auto AppPrivateLibraries(const AppParams* param) -> std::vector<std::string> {
+  std::vector<std::string> libraries;
+  if (param == nullptr) {
+    return libraries;
+  }
+  if (param->profile == AppProfile::kService) {
+    libraries.emplace_back("Threads::Threads");
+  }
+  if (param->allocator_selection) {
+    libraries.push_back(param->name + "_allocator");
+  }
+  libraries.insert(libraries.end(), param->libraries.cbegin(),
+                   param->libraries.cend());
+  return libraries;
+}
+
 auto BuildTestOption(const CommonParams* param) -> std::string {
   if (param == nullptr) {
     return "";
@@ -747,4 +1610,14 @@ auto BuildTestOption(const CommonParams* param) -> std::string {
   return s;
 }
 
-}  // namespace ci
\ No newline at end of file
+auto BuildBenchmarkOption(const CommonParams* param) -> std::string {
+  if (param == nullptr) {
+    return "";
+  }
+  std::string s{"BUILD_"};
+  s.append(ToUpperIdentifier(param->name));
+  s.append("_BENCHMARKS");
+  return s;
+}
+
+}  // namespace ci
@@ -0,0 +1,509 @@
+#include "cpp_init/instrumentation_module.h"
+
+#include <string_view>
+#include <utility>
+
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+constexpr std::string_view kInstrumentationHeader{R"tmpl(#ifndef @GUARD@_INSTRUMENTATION_H
+#define @GUARD@_INSTRUMENTATION_H
+
+// Scoped timers, hardware counters and trace events for hot paths. Everything
+// in this header, including the macros below, compiles to nothing unless
+// @UPPER@_ENABLE_INSTRUMENTATION is set by the CMake option of the same name.
+//
+//   void Process() {
+//     @UPPER@_TRACE_SCOPE("Process");    // event in the Chrome trace
+//     @UPPER@_TIMER_SCOPE("Process");    // call count and total time
+//     @UPPER@_COUNTER_SCOPE("Process");  // cycles, instructions, cache misses
+//   }
+//
+// Names must be string literals, only the pointer is recorded.
+
+#if defined(@UPPER@_ENABLE_INSTRUMENTATION) && @UPPER@_ENABLE_INSTRUMENTATION
+
+#include <time.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace @NS@ {
+namespace instrumentation {
+
+// Monotonic clock in nanoseconds that isn't slewed by NTP.
+struct RawClock {
+  static auto Now() -> uint64_t {
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+           static_cast<uint64_t>(ts.tv_nsec);
+  }
+  static auto ToNanoseconds(uint64_t ticks) -> double {
+    return static_cast<double>(ticks);
+  }
+};
+
+// Time stamp counter, cheaper to read than RawClock. Assumes an invariant TSC;
+// the tick rate is calibrated against RawClock on first use. Other
+// architectures use RawClock.
+struct TscClock {
+  static auto Now() -> uint64_t {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return RawClock::Now();
+#endif
+  }
+  static auto ToNanoseconds(uint64_t ticks) -> double {
+    return static_cast<double>(ticks) / TicksPerNanosecond();
+  }
+  static auto TicksPerNanosecond() -> double;
+};
+
+// Call count and accumulated time of one timer scope, shared by all threads.
+class TimerStats {
+ public:
+  explicit TimerStats(const char* name);
+
+  auto Add(double nanoseconds) -> void {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    nanoseconds_.fetch_add(static_cast<uint64_t>(nanoseconds),
+                           std::memory_order_relaxed);
+  }
+  auto Name() const -> const char* { return name_; }
+  auto Count() const -> uint64_t {
+    return count_.load(std::memory_order_relaxed);
+  }
+  auto Nanoseconds() const -> uint64_t {
+    return nanoseconds_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const char* name_;
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> nanoseconds_{0};
+};
+
+template <typename Clock = TscClock>
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(TimerStats& stats) : stats_{stats}, start_{Clock::Now()} {}
+  ~ScopedTimer() { stats_.Add(Clock::ToNanoseconds(Clock::Now() - start_)); }
+  ScopedTimer(const ScopedTimer&) = delete;
+  auto operator=(const ScopedTimer&) -> ScopedTimer& = delete;
+
+ private:
+  TimerStats& stats_;
+  uint64_t start_;
+};
+
+struct CounterValues {
+  uint64_t cycles{0};
+  uint64_t instructions{0};
+  uint64_t cache_misses{0};
+};
+
+// Cycles, instructions and cache misses of the calling thread, counted in user
+// space with perf_event_open. Valid() is false when the kernel refuses access,
+// see /proc/sys/kernel/perf_event_paranoid.
+class PerfCounters {
+ public:
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  auto operator=(const PerfCounters&) -> PerfCounters& = delete;
+
+  auto Valid() const -> bool { return fds_[0] >= 0; }
+  auto Read() const -> CounterValues;
+
+ private:
+  std::array<int, 3> fds_{-1, -1, -1};
+};
+
+// Counters of the calling thread, opened on first use.
+auto ThreadCounters() -> PerfCounters&;
+
+class CounterStats {
+ public:
+  explicit CounterStats(const char* name);
+
+  auto Add(const CounterValues& values) -> void {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    cycles_.fetch_add(values.cycles, std::memory_order_relaxed);
+    instructions_.fetch_add(values.instructions, std::memory_order_relaxed);
+    cache_misses_.fetch_add(values.cache_misses, std::memory_order_relaxed);
+  }
+  auto Name() const -> const char* { return name_; }
+  auto Count() const -> uint64_t {
+    return count_.load(std::memory_order_relaxed);
+  }
+  auto Total() const -> CounterValues {
+    return {cycles_.load(std::memory_order_relaxed),
+            instructions_.load(std::memory_order_relaxed),
+            cache_misses_.load(std::memory_order_relaxed)};
+  }
+
+ private:
+  const char* name_;
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> cycles_{0};
+  std::atomic<uint64_t> instructions_{0};
+  std::atomic<uint64_t> cache_misses_{0};
+};
+
+class CounterScope {
+ public:
+  explicit CounterScope(CounterStats& stats)
+      : stats_{stats}, counters_{ThreadCounters()}, start_{counters_.Read()} {}
+  ~CounterScope() {
+    if (!counters_.Valid()) {
+      return;
+    }
+    const auto end = counters_.Read();
+    stats_.Add({end.cycles - start_.cycles,
+                end.instructions - start_.instructions,
+                end.cache_misses - start_.cache_misses});
+  }
+  CounterScope(const CounterScope&) = delete;
+  auto operator=(const CounterScope&) -> CounterScope& = delete;
+
+ private:
+  CounterStats& stats_;
+  PerfCounters& counters_;
+  CounterValues start_;
+};
+
+struct TraceEvent {
+  const char* name{nullptr};
+  uint64_t start{0};
+  uint64_t duration{0};
+};
+
+// Fixed size ring of trace events written by a single thread. When the ring is
+// full the oldest events are overwritten.
+class TraceBuffer {
+ public:
+  static constexpr std::size_t kCapacity{1U << 14U};
+
+  explicit TraceBuffer(uint32_t thread_id) : thread_id_{thread_id} {}
+
+  auto Record(const char* name, uint64_t start, uint64_t duration) -> void {
+    const auto head = head_.load(std::memory_order_relaxed);
+    events_[head & (kCapacity - 1)] = TraceEvent{name, start, duration};
+    head_.store(head + 1, std::memory_order_release);
+  }
+  auto Head() const -> uint64_t { return head_.load(std::memory_order_acquire); }
+  auto Event(uint64_t index) const -> const TraceEvent& {
+    return events_[index & (kCapacity - 1)];
+  }
+  auto ThreadId() const -> uint32_t { return thread_id_; }
+
+ private:
+  uint32_t thread_id_;
+  std::atomic<uint64_t> head_{0};
+  std::array<TraceEvent, kCapacity> events_{};
+};
+
+// Trace buffer of the calling thread, registered on first use.
+auto ThreadTraceBuffer() -> TraceBuffer&;
+
+class TraceScope {
+ public:
+  explicit TraceScope(const char* name) : name_{name}, start_{RawClock::Now()} {}
+  ~TraceScope() {
+    ThreadTraceBuffer().Record(name_, start_, RawClock::Now() - start_);
+  }
+  TraceScope(const TraceScope&) = delete;
+  auto operator=(const TraceScope&) -> TraceScope& = delete;
+
+ private:
+  const char* name_;
+  uint64_t start_;
+};
+
+// Writes the recorded events of all threads in the Chrome trace event format
+// (chrome://tracing, Perfetto). Events recorded while writing may be torn, so
+// call this when the traced threads are idle.
+auto WriteChromeTrace(const char* path) -> bool;
+
+// Writes a summary of all timer and counter scopes.
+auto WriteReport(std::FILE* out) -> void;
+
+}  // namespace instrumentation
+}  // namespace @NS@
+
+#define @UPPER@_INSTRUMENTATION_CONCAT_INNER(a, b) a##b
+#define @UPPER@_INSTRUMENTATION_CONCAT(a, b) \
+  @UPPER@_INSTRUMENTATION_CONCAT_INNER(a, b)
+#define @UPPER@_TRACE_SCOPE(name)                                    \
+  const ::@NS@::instrumentation::TraceScope                          \
+      @UPPER@_INSTRUMENTATION_CONCAT(trace_scope_, __LINE__) { name }
+#define @UPPER@_TIMER_SCOPE(name)                                          \
+  static ::@NS@::instrumentation::TimerStats                               \
+      @UPPER@_INSTRUMENTATION_CONCAT(timer_stats_, __LINE__){name};        \
+  const ::@NS@::instrumentation::ScopedTimer<>                             \
+      @UPPER@_INSTRUMENTATION_CONCAT(timer_scope_, __LINE__) {             \
+    @UPPER@_INSTRUMENTATION_CONCAT(timer_stats_, __LINE__)                 \
+  }
+#define @UPPER@_COUNTER_SCOPE(name)                                        \
+  static ::@NS@::instrumentation::CounterStats                             \
+      @UPPER@_INSTRUMENTATION_CONCAT(counter_stats_, __LINE__){name};      \
+  const ::@NS@::instrumentation::CounterScope                              \
+      @UPPER@_INSTRUMENTATION_CONCAT(counter_scope_, __LINE__) {           \
+    @UPPER@_INSTRUMENTATION_CONCAT(counter_stats_, __LINE__)               \
+  }
+
+#else
+
+#define @UPPER@_TRACE_SCOPE(name) static_cast<void>(0)
+#define @UPPER@_TIMER_SCOPE(name) static_cast<void>(0)
+#define @UPPER@_COUNTER_SCOPE(name) static_cast<void>(0)
+
+#endif  // @UPPER@_ENABLE_INSTRUMENTATION
+
+#endif  // @GUARD@_INSTRUMENTATION_H
+)tmpl"};
+
+constexpr std::string_view kInstrumentationSource{R"tmpl(#include "@NAME@/instrumentation.h"
+
+#if defined(@UPPER@_ENABLE_INSTRUMENTATION) && @UPPER@_ENABLE_INSTRUMENTATION
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace @NS@ {
+namespace instrumentation {
+namespace {
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<TraceBuffer>> buffers;
+  std::vector<const TimerStats*> timers;
+  std::vector<const CounterStats*> counters;
+};
+
+// Never destroyed, so buffers and stats can still be used by threads and
+// static destructors that outlive main().
+auto GetRegistry() -> Registry& {
+  static auto* registry = new Registry();
+  return *registry;
+}
+
+auto OpenCounter(uint64_t config, int group_fd) -> int {
+  perf_event_attr attr{};
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.size = sizeof(attr);
+  attr.config = config;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0));
+}
+
+auto WriteJsonString(std::FILE* out, const char* text) -> void {
+  std::fputc('"', out);
+  for (const char* c = text; *c != '\0'; ++c) {
+    if (*c == '"' || *c == '\\') {
+      std::fputc('\\', out);
+    }
+    std::fputc(*c, out);
+  }
+  std::fputc('"', out);
+}
+
+}  // namespace
+
+auto TscClock::TicksPerNanosecond() -> double {
+#if defined(__x86_64__) || defined(__i386__)
+  static const double ticks_per_ns = [] {
+    const auto start_ns = RawClock::Now();
+    const auto start_ticks = Now();
+    while (RawClock::Now() - start_ns < 10000000) {
+    }
+    const auto ticks = Now() - start_ticks;
+    return static_cast<double>(ticks) /
+           static_cast<double>(RawClock::Now() - start_ns);
+  }();
+  return ticks_per_ns;
+#else
+  return 1.0;
+#endif
+}
+
+TimerStats::TimerStats(const char* name) : name_{name} {
+  auto& registry = GetRegistry();
+  const std::lock_guard<std::mutex> lock{registry.mutex};
+  registry.timers.push_back(this);
+}
+
+CounterStats::CounterStats(const char* name) : name_{name} {
+  auto& registry = GetRegistry();
+  const std::lock_guard<std::mutex> lock{registry.mutex};
+  registry.counters.push_back(this);
+}
+
+PerfCounters::PerfCounters() {
+  fds_[0] = OpenCounter(PERF_COUNT_HW_CPU_CYCLES, -1);
+  if (fds_[0] < 0) {
+    return;
+  }
+  fds_[1] = OpenCounter(PERF_COUNT_HW_INSTRUCTIONS, fds_[0]);
+  fds_[2] = OpenCounter(PERF_COUNT_HW_CACHE_MISSES, fds_[0]);
+  if (fds_[1] < 0 || fds_[2] < 0) {
+    for (auto& fd : fds_) {
+      if (fd >= 0) {
+        close(fd);
+      }
+      fd = -1;
+    }
+  }
+}
+
+PerfCounters::~PerfCounters() {
+  for (const auto fd : fds_) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+}
+
+auto PerfCounters::Read() const -> CounterValues {
+  // PERF_FORMAT_GROUP: the number of counters followed by their values in the
+  // order they were added to the group.
+  std::array<uint64_t, 4> data{};
+  if (!Valid() || read(fds_[0], data.data(), sizeof(data)) !=
+                      static_cast<ssize_t>(sizeof(data))) {
+    return {};
+  }
+  return {data[1], data[2], data[3]};
+}
+
+auto ThreadCounters() -> PerfCounters& {
+  thread_local PerfCounters counters;
+  return counters;
+}
+
+auto ThreadTraceBuffer() -> TraceBuffer& {
+  thread_local const std::shared_ptr<TraceBuffer> buffer = [] {
+    auto& registry = GetRegistry();
+    const std::lock_guard<std::mutex> lock{registry.mutex};
+    auto ptr = std::make_shared<TraceBuffer>(
+        static_cast<uint32_t>(registry.buffers.size() + 1));
+    registry.buffers.push_back(ptr);
+    return ptr;
+  }();
+  return *buffer;
+}
+
+auto WriteChromeTrace(const char* path) -> bool {
+  std::FILE* out = std::fopen(path, "w");
+  if (out == nullptr) {
+    return false;
+  }
+  auto& registry = GetRegistry();
+  const std::lock_guard<std::mutex> lock{registry.mutex};
+  std::fputs("{\"traceEvents\":[", out);
+  bool first{true};
+  for (const auto& buffer : registry.buffers) {
+    const auto head = buffer->Head();
+    const auto begin = head > TraceBuffer::kCapacity
+                           ? head - TraceBuffer::kCapacity
+                           : 0;
+    for (auto i = begin; i < head; ++i) {
+      const auto& event = buffer->Event(i);
+      std::fputs(first ? "\n" : ",\n", out);
+      first = false;
+      std::fputs("{\"name\":", out);
+      WriteJsonString(out, event.name);
+      std::fprintf(out,
+                   ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,"
+                   "\"dur\":%.3f}",
+                   buffer->ThreadId(), static_cast<double>(event.start) / 1e3,
+                   static_cast<double>(event.duration) / 1e3);
+    }
+  }
+  std::fputs("\n],\"displayTimeUnit\":\"ns\"}\n", out);
+  return std::fclose(out) == 0;
+}
+
+auto WriteReport(std::FILE* out) -> void {
+  auto& registry = GetRegistry();
+  const std::lock_guard<std::mutex> lock{registry.mutex};
+  for (const auto* timer : registry.timers) {
+    const auto count = timer->Count();
+    std::fprintf(out, "timer %s: %llu calls, %.1f ns/call\n", timer->Name(),
+                 static_cast<unsigned long long>(count),
+                 count == 0 ? 0.0
+                            : static_cast<double>(timer->Nanoseconds()) /
+                                  static_cast<double>(count));
+  }
+  for (const auto* counter : registry.counters) {
+    const auto count = counter->Count();
+    const auto total = counter->Total();
+    std::fprintf(out,
+                 "counters %s: %llu calls, %llu cycles, %llu instructions, "
+                 "%llu cache misses, IPC %.2f\n",
+                 counter->Name(), static_cast<unsigned long long>(count),
+                 static_cast<unsigned long long>(total.cycles),
+                 static_cast<unsigned long long>(total.instructions),
+                 static_cast<unsigned long long>(total.cache_misses),
+                 total.cycles == 0 ? 0.0
+                                   : static_cast<double>(total.instructions) /
+                                         static_cast<double>(total.cycles));
+  }
+}
+
+}  // namespace instrumentation
+}  // namespace @NS@
+
+#endif  // @UPPER@_ENABLE_INSTRUMENTATION
+)tmpl"};
+
+}  // namespace
+
+auto WriteInstrumentationModule(const std::filesystem::path& project_path,
+                                const LibraryParams* param) -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteInstrumentationModule")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteInstrumentationModule") << "param is a nullptr";
+    return 2;
+  }
+  const auto substitutions =
+      ProjectSubstitutions(param->name, param->cpp_namespace);
+  const std::pair<std::filesystem::path, std::string_view> files[]{
+      {project_path / "include" / param->name / "instrumentation.h",
+       kInstrumentationHeader},
+      {project_path / "src" / "instrumentation.cpp", kInstrumentationSource},
+  };
+  for (const auto& [path, text] : files) {
+    if (WriteTextFile(path, Substitute(text, substitutions)) != 0) {
+      Log(LogLevel::kError, "WriteInstrumentationModule") << "failed to write "
+                                                          << path;
+      return 3;
+    }
+  }
+  return 0;
+}
+
+}  // namespace ci
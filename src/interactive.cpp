@@ -1,8 +1,11 @@
 #include "cpp_init/interactive.h"
 
-#include <iostream>
 #include <optional>
 
+#include "cpp_init/cli.h"
+#include "cpp_init/console.h"
+#include "cpp_init/log.h"
+
 namespace ci {
 
 auto CreateSuperProject() -> std::unique_ptr<CommonParams>;
@@ -10,62 +13,54 @@ auto CreateLibraryQuestion() -> std::unique_ptr<CommonParams>;
 auto CreateApplicationQuestion() -> std::unique_ptr<CommonParams>;
 
 auto Question(std::string_view question) -> std::string {
-  std::cout << question << ": ";
-  std::string answer;
-  std::cin >> answer;
-  return answer;
+  ConsoleWrite(question);
+  ConsoleWrite(": ");
+  return ConsoleReadWord().value_or(std::string{});
 }
 
 auto QuestionUint8(std::string_view question) -> uint8_t {
-  bool is_int{false};
-  uint8_t value;
-  do {
-    std::cout << question << ": ";
-    std::string tmp;
-    std::cin >> tmp;
-    try {
-      value = std::stoi(tmp);
-      is_int = true;
-    } catch (std::invalid_argument&) {
-      is_int = false;
-    } catch (std::out_of_range&) {
-      is_int = false;
+  uint8_t value{0};
+  while (true) {
+    ConsoleWrite(question);
+    ConsoleWrite(": ");
+    const auto answer = ConsoleReadWord();
+    if (!answer) {
+      return 0;
+    }
+    if (ParseNumber(*answer, value)) {
+      return value;
     }
-  } while (!is_int);
-  return value;
+  }
 }
 
 auto QuestionOptions(std::string_view question,
                      const std::vector<std::string>& options) -> std::size_t {
   const auto size{options.size()};
-  auto pos{size};
-  bool is_int{false};
-  do {
-    std::cout << question << std::endl;
+  std::size_t pos{0};
+  while (true) {
+    ConsoleWrite(question);
+    ConsoleWrite("\n");
     for (std::size_t i{0}; i < size; ++i) {
-      std::cout << (i + 1) << " " << options[i] << std::endl;
+      ConsoleWrite(i + 1);
+      ConsoleWrite(" ");
+      ConsoleWrite(options[i]);
+      ConsoleWrite("\n");
+    }
+    ConsoleWrite("Answer [1-");
+    ConsoleWrite(size);
+    ConsoleWrite("]: ");
+    const auto answer = ConsoleReadWord();
+    if (!answer) {
+      return size;
     }
-    std::cout << "Answer [" << 1 << "-" << size << "]: ";
-    std::string tmp;
-    std::cin >> tmp;
-    try {
-      pos = std::stoi(tmp);
-      if (pos > 0 && pos <= size) {
-        --pos;
-        is_int = true;
-      }
-    } catch (std::invalid_argument&) {
-      is_int = false;
-    } catch (std::out_of_range&) {
-      is_int = false;
+    if (ParseNumber(*answer, pos) && pos > 0 && pos <= size) {
+      return pos - 1;
     }
-  } while (!is_int);
-  return pos;
+  }
 }
 
 [[maybe_unused]] auto YesNoQuestion(std::string_view question) -> bool {
-  std::optional<bool> answer;
-  auto isYesNo = [](const std::string& answer) -> std::optional<bool> {
+  auto isYesNo = [](std::string_view answer) -> std::optional<bool> {
     if (answer == "Y" || answer == "y" || answer == "Yes" || answer == "YES") {
       return {true};
     }
@@ -74,13 +69,17 @@ auto QuestionOptions(std::string_view question,
     }
     return {};
   };
-  std::string tmp;
+  std::optional<bool> result;
   do {
-    std::cout << question << " [y|n]: ";
-    std::cin >> tmp;
-    answer = isYesNo(tmp);
-  } while (!answer.has_value());
-  return answer.value();
+    ConsoleWrite(question);
+    ConsoleWrite(" [y|n]: ");
+    const auto answer = ConsoleReadWord();
+    if (!answer) {
+      return false;
+    }
+    result = isYesNo(*answer);
+  } while (!result.has_value());
+  return result.value();
 }
 
 auto CreateProjectQuestions() -> std::vector<std::unique_ptr<CommonParams>> {
@@ -112,6 +111,11 @@ auto CreateProjectQuestions() -> std::vector<std::unique_ptr<CommonParams>> {
     }
     vec.push_back(std::move(super_project));
   }
+  if (ConsoleInputEnded()) {
+    Log(LogLevel::kError, "CreateProjectQuestions")
+        << "unexpected end of input";
+    vec.clear();
+  }
   return vec;
 }
 auto CreateSuperProject() -> std::unique_ptr<CommonParams> {
@@ -123,23 +127,55 @@ auto CreateSuperProject() -> std::unique_ptr<CommonParams> {
 auto CreateApplicationQuestion() -> std::unique_ptr<CommonParams> {
   std::unique_ptr<CommonParams> ptr(new AppParams());
   auto* param = static_cast<AppParams*>(ptr.get());
-  std::cout << "\n\n";
+  ConsoleWrite("\n\n");
   param->name = Question("Application name");
   param->output_name = Question("Name of the executable");
   param->cmake_namespace = Question("CMake namespace");
   param->cpp_namespace = Question("C++ namespace");
   param->cpp_standard = QuestionUint8("CXX standard");
+  std::vector<std::string> profiles;
+  profiles.emplace_back("Empty application");
+  profiles.emplace_back("Network service (io_uring/epoll event loop, C++17)");
+  if (QuestionOptions({"Application profile"}, profiles) == 1) {
+    param->profile = AppProfile::kService;
+  }
+  param->allocator_selection = YesNoQuestion(
+      "Add allocator selection (system, jemalloc, mimalloc, tcmalloc) with "
+      "statistics and a benchmark?");
+  param->build_config = YesNoQuestion(
+      "Add a constexpr build configuration header (build_config.h, C++17)?");
+  param->embed_resources = YesNoQuestion(
+      "Compile the files in resources/ into the executable (C++20)?");
+  param->fast_startup = YesNoQuestion(
+      "Link with the fast-startup profile and add a startup latency test?");
   return ptr;
 }
 auto CreateLibraryQuestion() -> std::unique_ptr<CommonParams> {
   std::unique_ptr<CommonParams> ptr(new LibraryParams());
   auto* param = static_cast<LibraryParams*>(ptr.get());
-  std::cout << "\n\n";
+  ConsoleWrite("\n\n");
   param->name = Question("Library name");
   param->alias = Question("CMake library alias");
   param->cmake_namespace = Question("CMake namespace");
   param->cpp_namespace = Question("C++ namespace");
   param->cpp_standard = QuestionUint8("CXX standard");
+  std::vector<std::string> profiles;
+  profiles.emplace_back("Empty library");
+  profiles.emplace_back(
+      "Concurrency primitives (SPSC/MPMC rings, work-stealing thread pool, "
+      "C++17)");
+  if (QuestionOptions({"Library profile"}, profiles) == 1) {
+    param->profile = LibraryProfile::kConcurrency;
+  }
+  param->instrumentation = YesNoQuestion(
+      "Add an instrumentation module (timers, perf counters, tracing, C++17)?");
+  param->explicit_instantiation = YesNoQuestion(
+      "Add explicit template instantiation scaffolding (_fwd.h, _impl.h)?");
+  param->object_library = YesNoQuestion(
+      "Compile the sources once into an OBJECT library shared by the library, "
+      "a shared variant and the tests?");
+  param->build_config = YesNoQuestion(
+      "Add a constexpr build configuration header (build_config.h, C++17)?");
   return ptr;
 }
 
@@ -0,0 +1,490 @@
+#include "cpp_init/log.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ci {
+namespace {
+
+constexpr std::size_t kBufferCapacity{1024};
+// The writer wakes up on its own at this interval; producers only wake it
+// for errors and for buffers that are filling up.
+constexpr std::chrono::milliseconds kWriterInterval{20};
+
+struct Record {
+  LogRecord::Data data;
+  std::chrono::system_clock::time_point time;
+  uint32_t thread{0};
+  uint64_t sequence{0};
+};
+
+// Single-producer single-consumer ring of records. The producer is the
+// thread that owns the buffer, the consumer the writer thread.
+class ThreadBuffer {
+ public:
+  explicit ThreadBuffer(uint32_t thread) : thread_{thread} {}
+
+  auto TryPush(Record&& record) -> bool {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == kBufferCapacity) {
+      return false;
+    }
+    slots_[tail % kBufferCapacity] = std::move(record);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto TryPop(Record& record) -> bool {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    record = std::move(slots_[head % kBufferCapacity]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto Size() const -> std::size_t {
+    return tail_.load(std::memory_order_relaxed) -
+           head_.load(std::memory_order_relaxed);
+  }
+
+  auto Thread() const -> uint32_t { return thread_; }
+
+  // Records pushed by this thread, orders records with equal time stamps.
+  uint64_t sequence{0};
+
+ private:
+  const uint32_t thread_;
+  alignas(64) std::atomic<std::size_t> head_{0};
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  Record slots_[kBufferCapacity];
+};
+
+auto LevelName(LogLevel level) -> std::string_view {
+  switch (level) {
+    case LogLevel::kDebug:
+      return "debug";
+    case LogLevel::kInfo:
+      return "info";
+    case LogLevel::kWarning:
+      return "warning";
+    case LogLevel::kError:
+      return "error";
+    case LogLevel::kOff:
+      break;
+  }
+  return "off";
+}
+
+auto AppendJsonString(std::string& out, std::string_view text) -> void {
+  out.push_back('"');
+  for (const char c : text) {
+    switch (c) {
+      case '"':
+        out.append("\\\"");
+        break;
+      case '\\':
+        out.append("\\\\");
+        break;
+      case '\n':
+        out.append("\\n");
+        break;
+      case '\t':
+        out.append("\\t");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buffer[8];
+          std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+          out.append(buffer);
+        } else {
+          out.push_back(c);
+        }
+    }
+  }
+  out.push_back('"');
+}
+
+auto AppendTime(std::string& out, std::chrono::system_clock::time_point time)
+    -> void {
+  const auto since_epoch = time.time_since_epoch();
+  const auto seconds =
+      std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+  const auto micros =
+      std::chrono::duration_cast<std::chrono::microseconds>(since_epoch -
+                                                            seconds);
+  const std::time_t t{static_cast<std::time_t>(seconds.count())};
+  std::tm tm{};
+  gmtime_r(&t, &tm);
+  char buffer[96];
+  std::snprintf(buffer, sizeof(buffer), "%04d-%02d-%02dT%02d:%02d:%02d.%06ldZ",
+                tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour,
+                tm.tm_min, tm.tm_sec, static_cast<long>(micros.count()));
+  out.append(buffer);
+}
+
+auto Format(std::string& out, const Record& record, LogFormat format) -> void {
+  const auto& data = record.data;
+  if (format == LogFormat::kJson) {
+    out.append("{\"time\":\"");
+    AppendTime(out, record.time);
+    out.append("\",\"level\":\"");
+    out.append(LevelName(data.level));
+    out.append("\",\"thread\":");
+    out.append(std::to_string(record.thread));
+    out.append(",\"source\":");
+    AppendJsonString(out, data.source);
+    out.append(",\"message\":");
+    AppendJsonString(out, data.message);
+    for (const auto& [key, value, is_number] : data.fields) {
+      out.push_back(',');
+      AppendJsonString(out, key);
+      out.push_back(':');
+      if (is_number) {
+        out.append(value);
+      } else {
+        AppendJsonString(out, value);
+      }
+    }
+    out.append("}\n");
+    return;
+  }
+  if (data.level != LogLevel::kInfo) {
+    out.append(LevelName(data.level));
+    out.append(": ");
+  }
+  out.append(data.source);
+  out.append(": ");
+  out.append(data.message);
+  for (const auto& [key, value, is_number] : data.fields) {
+    out.push_back(' ');
+    out.append(key);
+    out.push_back('=');
+    out.append(value);
+  }
+  out.push_back('\n');
+}
+
+auto WriteAll(int fd, std::string_view text) -> void {
+  while (!text.empty()) {
+    const auto written = ::write(fd, text.data(), text.size());
+    if (written < 0) {
+      return;
+    }
+    text.remove_prefix(static_cast<std::size_t>(written));
+  }
+}
+
+auto DefaultConfig() -> LogConfig {
+  LogConfig config;
+  if (const auto* level = std::getenv("CPP_INIT_LOG_LEVEL")) {
+    config.level = ParseLogLevel(level).value_or(config.level);
+  }
+  if (const auto* format = std::getenv("CPP_INIT_LOG_FORMAT")) {
+    config.format = ParseLogFormat(format).value_or(config.format);
+  }
+  return config;
+}
+
+// Set when the logger is constructed, so FlushLog doesn't create the
+// logger of a run that never logged.
+std::atomic<bool> logger_created{false};
+
+class Logger {
+ public:
+  static auto Instance() -> Logger& {
+    // Never destroyed, threads may log during static destruction.
+    static auto* logger = new Logger{};
+    return *logger;
+  }
+
+  auto Enabled(LogLevel level) const -> bool {
+    return level != LogLevel::kOff &&
+           level >= level_.load(std::memory_order_relaxed);
+  }
+
+  auto Configure(const LogConfig& config) -> void {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    config_ = config;
+    level_.store(config.level);
+  }
+
+  auto Config() -> LogConfig {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    return config_;
+  }
+
+  auto Submit(LogRecord::Data&& data) -> void {
+    auto* buffer = LocalBuffer();
+    Record record{std::move(data), std::chrono::system_clock::now(),
+                  buffer->Thread(), buffer->sequence++};
+    if (!running_.load(std::memory_order_acquire) && !Start()) {
+      WriteDirect(record);
+      return;
+    }
+    const bool urgent{record.data.level >= LogLevel::kError};
+    while (!buffer->TryPush(std::move(record))) {
+      Wake();
+      std::this_thread::yield();
+      if (!running_.load(std::memory_order_acquire)) {
+        WriteDirect(record);
+        return;
+      }
+    }
+    if (!running_.load()) {
+      // Flushed while the record was queued; the writer is gone.
+      DrainAndWrite();
+    } else if (urgent || buffer->Size() > kBufferCapacity / 2) {
+      Wake();
+    }
+  }
+
+  auto Flush() -> void {
+    std::thread writer;
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      // stopped_ rather than running_, which is cleared after the lock is
+      // released, so only one caller takes and joins the writer.
+      if (stopped_ || !running_.load()) {
+        return;
+      }
+      stopped_ = true;
+      stop_ = true;
+      writer = std::move(writer_);
+    }
+    running_.store(false);
+    wake_.notify_one();
+    writer.join();
+    DrainAndWrite();
+  }
+
+ private:
+  Logger() : config_{DefaultConfig()}, level_{config_.level} {
+    logger_created.store(true, std::memory_order_release);
+  }
+
+  auto LocalBuffer() -> ThreadBuffer* {
+    thread_local ThreadBuffer* buffer{nullptr};
+    if (buffer == nullptr) {
+      // Buffers are owned by the logger and kept after their thread exits,
+      // so the writer can still drain them.
+      const std::lock_guard<std::mutex> lock{mutex_};
+      buffers_.push_back(std::make_unique<ThreadBuffer>(
+          static_cast<uint32_t>(buffers_.size())));
+      buffer = buffers_.back().get();
+      buffer_count_.store(buffers_.size(), std::memory_order_release);
+    }
+    return buffer;
+  }
+
+  // Starts the writer thread unless the logger was flushed already.
+  auto Start() -> bool {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    if (running_.load()) {
+      return true;
+    }
+    if (stopped_) {
+      return false;
+    }
+    writer_ = std::thread{[this] { Run(); }};
+    running_.store(true, std::memory_order_release);
+    std::atexit([] { FlushLog(); });
+    return true;
+  }
+
+  auto Wake() -> void {
+    if (sleeping_.load()) {
+      { const std::lock_guard<std::mutex> lock{mutex_}; }
+      wake_.notify_one();
+    }
+  }
+
+  // Writes the pending records of every thread, oldest first.
+  auto DrainAndWrite() -> void {
+    const std::lock_guard<std::mutex> lock{drain_mutex_};
+    Drain(drained_);
+    Write(drained_);
+  }
+
+  // Moves the pending records of every thread to records.
+  auto Drain(std::vector<Record>& records) -> void {
+    const auto count = buffer_count_.load(std::memory_order_acquire);
+    std::vector<ThreadBuffer*> buffers;
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      for (std::size_t i{0}; i < count; ++i) {
+        buffers.push_back(buffers_[i].get());
+      }
+    }
+    Record record;
+    for (auto* buffer : buffers) {
+      while (buffer->TryPop(record)) {
+        records.push_back(std::move(record));
+      }
+    }
+  }
+
+  auto Write(std::vector<Record>& records) -> void {
+    if (records.empty()) {
+      return;
+    }
+    std::sort(records.begin(), records.end(),
+              [](const Record& a, const Record& b) {
+                if (a.time != b.time) {
+                  return a.time < b.time;
+                }
+                if (a.thread != b.thread) {
+                  return a.thread < b.thread;
+                }
+                return a.sequence < b.sequence;
+              });
+    const auto config = Config();
+    std::string text;
+    for (const auto& record : records) {
+      Format(text, record, config.format);
+    }
+    WriteAll(config.fd, text);
+    records.clear();
+  }
+
+  auto WriteDirect(const Record& record) -> void {
+    const auto config = Config();
+    std::string text;
+    Format(text, record, config.format);
+    const std::lock_guard<std::mutex> lock{drain_mutex_};
+    WriteAll(config.fd, text);
+  }
+
+  auto Run() -> void {
+    for (;;) {
+      DrainAndWrite();
+      std::unique_lock<std::mutex> lock{mutex_};
+      if (stop_) {
+        lock.unlock();
+        DrainAndWrite();
+        return;
+      }
+      sleeping_.store(true);
+      wake_.wait_for(lock, kWriterInterval);
+      sleeping_.store(false);
+    }
+  }
+
+  std::mutex mutex_;
+  // Serializes the consumers of the thread buffers.
+  std::mutex drain_mutex_;
+  std::vector<Record> drained_;
+  std::condition_variable wake_;
+  LogConfig config_;
+  std::atomic<LogLevel> level_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+  std::atomic<std::size_t> buffer_count_{0};
+  std::thread writer_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> sleeping_{false};
+  bool stop_{false};
+  bool stopped_{false};
+};
+
+}  // namespace
+
+auto ConfigureLog(const LogConfig& config) -> void {
+  Logger::Instance().Configure(config);
+}
+
+auto CurrentLogConfig() -> LogConfig { return Logger::Instance().Config(); }
+
+auto ParseLogLevel(std::string_view text) -> std::optional<LogLevel> {
+  for (const auto level : {LogLevel::kDebug, LogLevel::kInfo,
+                           LogLevel::kWarning, LogLevel::kError,
+                           LogLevel::kOff}) {
+    if (text == LevelName(level)) {
+      return level;
+    }
+  }
+  return std::nullopt;
+}
+
+auto ParseLogFormat(std::string_view text) -> std::optional<LogFormat> {
+  if (text == "human") {
+    return LogFormat::kHuman;
+  }
+  if (text == "json") {
+    return LogFormat::kJson;
+  }
+  return std::nullopt;
+}
+
+auto FlushLog() -> void {
+  if (logger_created.load(std::memory_order_acquire)) {
+    Logger::Instance().Flush();
+  }
+}
+
+LogRecord::LogRecord(LogLevel level, std::string_view source)
+    : enabled_{Logger::Instance().Enabled(level)} {
+  data_.level = level;
+  data_.source = source;
+}
+
+LogRecord::~LogRecord() {
+  if (enabled_) {
+    Logger::Instance().Submit(std::move(data_));
+  }
+}
+
+auto LogRecord::operator<<(std::string_view text) -> LogRecord& {
+  if (enabled_) {
+    data_.message.append(text);
+  }
+  return *this;
+}
+
+auto LogRecord::operator<<(const char* text) -> LogRecord& {
+  return *this << std::string_view{text};
+}
+
+auto LogRecord::operator<<(const std::string& text) -> LogRecord& {
+  return *this << std::string_view{text};
+}
+
+auto LogRecord::operator<<(char c) -> LogRecord& {
+  if (enabled_) {
+    data_.message.push_back(c);
+  }
+  return *this;
+}
+
+auto LogRecord::operator<<(const std::filesystem::path& path) -> LogRecord& {
+  return *this << std::string_view{path.native()};
+}
+
+auto LogRecord::Field(std::string_view key, std::string_view value)
+    -> LogRecord& {
+  if (enabled_) {
+    data_.fields.emplace_back(key, std::string{value}, false);
+  }
+  return *this;
+}
+
+auto LogRecord::Field(std::string_view key, int64_t value) -> LogRecord& {
+  if (enabled_) {
+    std::string text;
+    AppendNumber(text, value);
+    data_.fields.emplace_back(key, std::move(text), true);
+  }
+  return *this;
+}
+
+}  // namespace ci
@@ -1,10 +1,67 @@
-#include <iostream>
+#include <cstdlib>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <vector>
 
+#include "cpp_init/console.h"
+#include "cpp_init/deps.h"
 #include "cpp_init/generator.h"
 #include "cpp_init/interactive.h"
+#include "cpp_init/log.h"
+#include "cpp_init/synth.h"
 
-int main(int argc, char** argv) {
+namespace {
+
+// Consumes the leading --log-level and --log-format options. The logger is
+// only touched when one of them is given.
+auto ParseLogOptions(std::vector<std::string_view>& args) -> bool {
+  std::optional<ci::LogLevel> level;
+  std::optional<ci::LogFormat> format;
+  while (args.size() >= 2 &&
+         (args[0] == "--log-level" || args[0] == "--log-format")) {
+    if (args[0] == "--log-level") {
+      level = ci::ParseLogLevel(args[1]);
+      if (!level) {
+        ci::ConsoleError("unknown log level: ");
+        ci::ConsoleError(args[1]);
+        ci::ConsoleError("\n");
+        return false;
+      }
+    } else {
+      format = ci::ParseLogFormat(args[1]);
+      if (!format) {
+        ci::ConsoleError("unknown log format: ");
+        ci::ConsoleError(args[1]);
+        ci::ConsoleError("\n");
+        return false;
+      }
+    }
+    args.erase(args.begin(), args.begin() + 2);
+  }
+  if (level || format) {
+    auto config = ci::CurrentLogConfig();
+    config.level = level.value_or(config.level);
+    config.format = format.value_or(config.format);
+    ci::ConfigureLog(config);
+  }
+  return true;
+}
+
+auto Run(const std::vector<std::string_view>& args) -> int {
+  if (!args.empty() && args[0] == "deps") {
+    return ci::RunDeps(
+        std::vector<std::string_view>(args.begin() + 1, args.end()));
+  }
+  if (!args.empty() && args[0] == "synth") {
+    return ci::RunSynth(
+        std::vector<std::string_view>(args.begin() + 1, args.end()));
+  }
   const auto projects = ci::CreateProjectQuestions();
+  ci::FlushConsole();
+  if (projects.empty()) {
+    return EXIT_FAILURE;
+  }
   const auto current_path = std::filesystem::current_path();
   using opt_type = std::optional<const ci::SuperProjectParams*>;
   opt_type parent{};
@@ -14,7 +71,9 @@ int main(int argc, char** argv) {
         const auto* ptr = static_cast<ci::SuperProjectParams*>(project.get());
         parent = opt_type {ptr};
       }
-      ci::GenerateProject(current_path, project.get(), nullptr);
+      if (ci::GenerateProject(current_path, project.get(), nullptr) != 0) {
+        return EXIT_FAILURE;
+      }
     }
   }
   for (const auto & project : projects) {
@@ -23,7 +82,10 @@ int main(int argc, char** argv) {
       if (parent.has_value()) {
         tmp /= parent.value()->name;
       }
-      ci::GenerateProject(tmp, project.get(), parent.value_or(nullptr));
+      if (ci::GenerateProject(tmp, project.get(), parent.value_or(nullptr)) !=
+          0) {
+        return EXIT_FAILURE;
+      }
     }
   }
   for (const auto & project : projects) {
@@ -32,8 +94,23 @@ int main(int argc, char** argv) {
       if (parent.has_value()) {
         tmp /= parent.value()->name;
       }
-      ci::GenerateProject(tmp, project.get(), parent.value_or(nullptr));
+      if (ci::GenerateProject(tmp, project.get(), parent.value_or(nullptr)) !=
+          0) {
+        return EXIT_FAILURE;
+      }
     }
   }
   return EXIT_SUCCESS;
-}
\ No newline at end of file
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<std::string_view> args(argv + 1, argv + argc);
+  if (!ParseLogOptions(args)) {
+    return EXIT_FAILURE;
+  }
+  const auto rv = Run(args);
+  ci::FlushLog();
+  return rv;
+}
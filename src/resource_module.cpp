@@ -0,0 +1,311 @@
+#include "cpp_init/resource_module.h"
+
+#include <string_view>
+#include <utility>
+
+#include "cpp_init/blob_store.h"
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+// @NAME@, @NS@ and @GUARD@ are replaced by cpp_init, the RESOURCE_*
+// variables by embed_resources().
+constexpr std::string_view kResourcesHeader{R"tmpl(#ifndef @GUARD@_RESOURCES_H
+#define @GUARD@_RESOURCES_H
+
+// Generated by embed_resources() in cmake/resources.cmake from the files in
+// resources/. The data is part of the binary, so reading a resource needs no
+// file I/O. Every resource is followed by a NUL byte that isn't part of its
+// size.
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace @NS@::resources {
+
+enum class ResourceId : std::size_t {
+@RESOURCE_IDS@};
+
+// Paths relative to resources/, indexed by ResourceId.
+inline constexpr std::array<std::string_view, @RESOURCE_COUNT@> kNames{{
+@RESOURCE_NAMES@}};
+
+// Looks a resource up by its path; evaluated at compile time for a constant
+// name.
+constexpr auto Find(std::string_view name) -> std::optional<ResourceId> {
+  for (std::size_t i{0}; i < kNames.size(); ++i) {
+    if (kNames[i] == name) {
+      return static_cast<ResourceId>(i);
+    }
+  }
+  return std::nullopt;
+}
+
+auto Data(ResourceId id) -> std::span<const std::byte>;
+auto Text(ResourceId id) -> std::string_view;
+
+}  // namespace @NS@::resources
+
+#endif  // @GUARD@_RESOURCES_H
+)tmpl"};
+
+constexpr std::string_view kResourcesSource{R"tmpl(// Generated by embed_resources() in cmake/resources.cmake, RESOURCES_MODE
+// @RESOURCE_MODE@.
+
+#include "@NAME@/resources.h"
+
+@RESOURCE_DEFINITIONS@
+namespace @NS@::resources {
+namespace {
+
+struct Entry {
+  const unsigned char* begin;
+  const unsigned char* end;
+};
+
+// The last entry keeps the array from being empty.
+constexpr Entry kEntries[]{
+@RESOURCE_ENTRIES@    {nullptr, nullptr},
+};
+
+}  // namespace
+
+auto Data(ResourceId id) -> std::span<const std::byte> {
+  const auto& entry = kEntries[static_cast<std::size_t>(id)];
+  return std::as_bytes(std::span{entry.begin, entry.end});
+}
+
+auto Text(ResourceId id) -> std::string_view {
+  const auto data = Data(id);
+  return {reinterpret_cast<const char*>(data.data()), data.size()};
+}
+
+}  // namespace @NS@::resources
+)tmpl"};
+
+constexpr std::string_view kResourcesCmake{R"cmake(# Compiles the files below a directory into a target.
+#
+#   embed_resources(<target> NAME <name> DIRECTORY <dir>)
+#
+# Every file becomes a ResourceId in the generated <name>/resources.h, which
+# is configured from cmake/resources.h.in; cmake/resources.cpp.in holds the
+# data. RESOURCES_MODE selects how the data gets into the object file:
+#   embed   #embed (C23 and C++26; GCC 15 and Clang 19 accept it in C++)
+#   incbin  the .incbin assembler directive (GCC and Clang on ELF targets)
+#   array   a byte array written at build time, works with every compiler
+#   auto    the first of these the toolchain supports
+# Changed files are embedded again by the next build. Added or removed files
+# rerun CMake.
+
+if (CMAKE_SCRIPT_MODE_FILE AND DEFINED RESOURCES_INPUT)
+    # Writes the byte array of one file in array mode.
+    file(READ "${RESOURCES_INPUT}" _hex HEX)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1," _bytes "${_hex}")
+    string(REPEAT "0x..," 16 _row)
+    string(REGEX REPLACE "(${_row})" "\\1\n" _bytes "${_bytes}")
+    file(WRITE "${RESOURCES_OUTPUT}" "${_bytes}\n")
+    return()
+endif ()
+
+include_guard(GLOBAL)
+include(CheckCXXSourceCompiles)
+
+set(RESOURCES_MODE "auto" CACHE STRING
+    "How embed_resources() embeds files: auto, embed, incbin or array")
+set_property(CACHE RESOURCES_MODE PROPERTY STRINGS auto embed incbin array)
+
+function(_resources_mode out)
+    if (NOT RESOURCES_MODE STREQUAL "auto")
+        set(${out} ${RESOURCES_MODE} PARENT_SCOPE)
+        return()
+    endif ()
+    set(_probe "${CMAKE_BINARY_DIR}/CMakeFiles/resources_probe.txt")
+    file(WRITE "${_probe}" "x")
+    set(CMAKE_REQUIRED_QUIET ON)
+    check_cxx_source_compiles("
+constexpr unsigned char kData[]{
+#embed \"${_probe}\" suffix(,)
+    0};
+static_assert(sizeof(kData) == 2 && kData[0] == 'x');
+int main() { return 0; }" RESOURCES_HAVE_EMBED)
+    if (RESOURCES_HAVE_EMBED)
+        set(${out} embed PARENT_SCOPE)
+    elseif (CMAKE_CXX_COMPILER_ID MATCHES "GNU|Clang" AND NOT APPLE
+            AND NOT WIN32)
+        set(${out} incbin PARENT_SCOPE)
+    else ()
+        set(${out} array PARENT_SCOPE)
+    endif ()
+endfunction()
+
+# config/schema.json -> kConfigSchemaJson
+function(_resources_identifier out path)
+    string(MAKE_C_IDENTIFIER "${path}" _words)
+    string(TOLOWER "${_words}" _words)
+    string(REPLACE "_" ";" _words "${_words}")
+    set(_identifier k)
+    foreach (_word IN LISTS _words)
+        string(SUBSTRING "${_word}" 0 1 _first)
+        string(SUBSTRING "${_word}" 1 -1 _rest)
+        string(TOUPPER "${_first}" _first)
+        string(APPEND _identifier "${_first}${_rest}")
+    endforeach ()
+    set(${out} ${_identifier} PARENT_SCOPE)
+endfunction()
+
+function(embed_resources target)
+    cmake_parse_arguments(F "" "NAME;DIRECTORY" "" ${ARGN})
+    if (NOT F_NAME OR NOT F_DIRECTORY)
+        message(FATAL_ERROR "embed_resources: NAME and DIRECTORY are required")
+    endif ()
+    _resources_mode(RESOURCE_MODE)
+    if (NOT RESOURCE_MODE MATCHES "^(embed|incbin|array)$")
+        message(FATAL_ERROR
+                "embed_resources: unknown RESOURCES_MODE ${RESOURCE_MODE}")
+    endif ()
+
+    file(GLOB_RECURSE _files CONFIGURE_DEPENDS LIST_DIRECTORIES false
+         RELATIVE "${F_DIRECTORY}" "${F_DIRECTORY}/*")
+    list(SORT _files)
+    string(MAKE_C_IDENTIFIER "${F_NAME}" _prefix)
+    set(_out "${CMAKE_CURRENT_BINARY_DIR}/${F_NAME}_resources")
+    set(RESOURCE_IDS "")
+    set(RESOURCE_NAMES "")
+    set(RESOURCE_DEFINITIONS "")
+    set(RESOURCE_ENTRIES "")
+    set(_identifiers "")
+    set(_depends "")
+    set(_index 0)
+    foreach (_file IN LISTS _files)
+        set(_path "${F_DIRECTORY}/${_file}")
+        _resources_identifier(_identifier "${_file}")
+        if (_identifier IN_LIST _identifiers)
+            message(FATAL_ERROR "embed_resources: the ResourceId of ${_file}, "
+                                "${_identifier}, is already used")
+        endif ()
+        list(APPEND _identifiers ${_identifier})
+        string(REPLACE "\\" "\\\\" _name "${_file}")
+        string(REPLACE "\"" "\\\"" _name "${_name}")
+        string(APPEND RESOURCE_IDS "  ${_identifier},\n")
+        string(APPEND RESOURCE_NAMES "    \"${_name}\",\n")
+
+        set(_symbol "${_prefix}_resource_${_index}")
+        if (RESOURCE_MODE STREQUAL "incbin")
+            string(APPEND RESOURCE_DEFINITIONS
+                   "__asm__(\".section .rodata.${_symbol},\\\"a\\\"\\n\"\n"
+                   "        \".balign 16\\n\"\n"
+                   "        \".globl ${_symbol}_begin\\n\"\n"
+                   "        \".hidden ${_symbol}_begin\\n\"\n"
+                   "        \"${_symbol}_begin:\\n\"\n"
+                   "        \".incbin \\\"${_path}\\\"\\n\"\n"
+                   "        \".globl ${_symbol}_end\\n\"\n"
+                   "        \".hidden ${_symbol}_end\\n\"\n"
+                   "        \"${_symbol}_end:\\n\"\n"
+                   "        \".byte 0\\n\"\n"
+                   "        \".previous\\n\");\n"
+                   "extern \"C\" const unsigned char ${_symbol}_begin[];\n"
+                   "extern \"C\" const unsigned char ${_symbol}_end[];\n")
+            string(APPEND RESOURCE_ENTRIES
+                   "    {${_symbol}_begin, ${_symbol}_end},\n")
+            list(APPEND _depends "${_path}")
+        else ()
+            if (RESOURCE_MODE STREQUAL "embed")
+                set(_initializer "#embed \"${_path}\" suffix(,)")
+                list(APPEND _depends "${_path}")
+            else ()
+                set(_array "${_out}/data/${_index}.inc")
+                add_custom_command(
+                    OUTPUT "${_array}"
+                    COMMAND "${CMAKE_COMMAND}" "-DRESOURCES_INPUT=${_path}"
+                            "-DRESOURCES_OUTPUT=${_array}"
+                            -P "${CMAKE_CURRENT_FUNCTION_LIST_FILE}"
+                    DEPENDS "${_path}"
+                    COMMENT "Embedding ${_file}"
+                    VERBATIM)
+                set(_initializer "#include \"${_array}\"")
+                list(APPEND _depends "${_array}")
+            endif ()
+            string(APPEND RESOURCE_DEFINITIONS
+                   "alignas(16) constexpr unsigned char ${_symbol}[]{\n"
+                   "${_initializer}\n"
+                   "    0};\n")
+            string(APPEND RESOURCE_ENTRIES
+                   "    {${_symbol}, ${_symbol} + sizeof(${_symbol}) - 1},\n")
+        endif ()
+        math(EXPR _index "${_index} + 1")
+    endforeach ()
+    set(RESOURCE_COUNT ${_index})
+
+    configure_file("${CMAKE_CURRENT_SOURCE_DIR}/cmake/resources.h.in"
+                   "${_out}/include/${F_NAME}/resources.h" @ONLY)
+    configure_file("${CMAKE_CURRENT_SOURCE_DIR}/cmake/resources.cpp.in"
+                   "${_out}/resources.cpp" @ONLY)
+    set_source_files_properties("${_out}/resources.cpp" PROPERTIES
+                                OBJECT_DEPENDS "${_depends}")
+    target_sources(${target} PRIVATE "${_out}/resources.cpp")
+    target_include_directories(${target} PRIVATE "${_out}/include")
+    target_compile_features(${target} PRIVATE cxx_std_20)
+endfunction()
+)cmake"};
+
+constexpr std::string_view kExampleResource{
+    R"tmpl(Files in this directory are compiled into @NAME@. Read them with
+@NS@::resources::Text(@NS@::resources::ResourceId::kReadmeTxt).
+)tmpl"};
+
+}  // namespace
+
+auto WriteResourceModule(const std::filesystem::path& project_path,
+                         const AppParams* param, BlobStore* store) -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteResourceModule")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteResourceModule") << "param is a nullptr";
+    return 2;
+  }
+  const auto cmake_path = project_path / "cmake";
+  const auto resources_path = project_path / "resources";
+  for (const auto& dir : {cmake_path, resources_path}) {
+    std::error_code error_code;
+    std::filesystem::create_directories(dir, error_code);
+    if (error_code) {
+      Log(LogLevel::kError, "WriteResourceModule")
+          .Field("errno", error_code.value())
+          .Field("error", error_code.message())
+          << "failed to create directory: " << dir;
+      return 3;
+    }
+  }
+
+  const auto substitutions =
+      ProjectSubstitutions(param->name, param->cpp_namespace);
+  const std::pair<std::filesystem::path, std::string_view> files[]{
+      {cmake_path / "resources.h.in", kResourcesHeader},
+      {cmake_path / "resources.cpp.in", kResourcesSource},
+      {resources_path / "README.txt", kExampleResource},
+  };
+  for (const auto& [path, text] : files) {
+    if (WriteTextFile(path, Substitute(text, substitutions)) != 0) {
+      Log(LogLevel::kError, "WriteResourceModule") << "failed to write "
+                                                   << path;
+      return 4;
+    }
+  }
+  const auto cmake_file = cmake_path / "resources.cmake";
+  if (WriteSharedFile(cmake_file, kResourcesCmake, store) != 0) {
+    Log(LogLevel::kError, "WriteResourceModule") << "failed to write "
+                                                 << cmake_file;
+    return 4;
+  }
+  return 0;
+}
+
+}  // namespace ci
@@ -0,0 +1,1168 @@
+#include "cpp_init/service_profile.h"
+
+#include <string_view>
+#include <utility>
+
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+constexpr std::string_view kSpscQueueHeader{R"tmpl(#ifndef @GUARD@_SPSC_QUEUE_H
+#define @GUARD@_SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+namespace @NS@ {
+
+inline constexpr std::size_t kCacheLineSize{64};
+
+// Bounded lock-free queue for exactly one producer and one consumer thread.
+// The producer and consumer indices live on separate cache lines and each side
+// caches the other side's index, so the shared lines are only touched when the
+// queue looks full or empty.
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+ public:
+  auto TryPush(const T& value) -> bool {
+    const auto head = head_.load(std::memory_order_relaxed);
+    if (head - cached_tail_ == Capacity) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if (head - cached_tail_ == Capacity) {
+        return false;
+      }
+    }
+    slots_[head & kMask] = value;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  auto TryPop() -> std::optional<T> {
+    const auto tail = tail_.load(std::memory_order_relaxed);
+    if (tail == cached_head_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if (tail == cached_head_) {
+        return std::nullopt;
+      }
+    }
+    T value = slots_[tail & kMask];
+    tail_.store(tail + 1, std::memory_order_release);
+    return value;
+  }
+
+ private:
+  static constexpr std::size_t kMask{Capacity - 1};
+
+  alignas(kCacheLineSize) std::atomic<std::size_t> head_{0};
+  std::size_t cached_tail_{0};
+  alignas(kCacheLineSize) std::atomic<std::size_t> tail_{0};
+  std::size_t cached_head_{0};
+  alignas(kCacheLineSize) std::array<T, Capacity> slots_{};
+};
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_SPSC_QUEUE_H
+)tmpl"};
+
+constexpr std::string_view kEventLoopHeader{R"tmpl(#ifndef @GUARD@_EVENT_LOOP_H
+#define @GUARD@_EVENT_LOOP_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+
+#include "@NAME@/spsc_queue.h"
+
+namespace @NS@ {
+
+inline constexpr std::size_t kBufferSize{4096};
+
+// State shared between the acceptor thread and one worker thread. Accepted
+// sockets are handed over through a lock-free queue and the worker is woken
+// up through an eventfd.
+class Worker {
+ public:
+  explicit Worker(unsigned id) : id_{id} {}
+  ~Worker();
+  Worker(const Worker&) = delete;
+  auto operator=(const Worker&) -> Worker& = delete;
+
+  // Creates the eventfd, returns false when that fails.
+  auto Init() -> bool;
+
+  // Called from the acceptor thread only.
+  auto Post(int fd) -> bool;
+  auto Stop() -> void;
+
+  // Called from the worker thread only.
+  auto TakeIncoming() -> std::optional<int> { return incoming_.TryPop(); }
+  auto Stopping() const -> bool {
+    return stop_.load(std::memory_order_acquire);
+  }
+  auto WakeFd() const -> int { return wake_fd_; }
+  auto Id() const -> unsigned { return id_; }
+
+ private:
+  auto Wake() -> void;
+
+  unsigned id_;
+  int wake_fd_{-1};
+  std::atomic<bool> stop_{false};
+  SpscQueue<int, 4096> incoming_;
+};
+
+// Echo loop run by a worker thread until the worker is stopped.
+class EventLoop {
+ public:
+  virtual ~EventLoop() = default;
+
+  virtual auto Run() -> void = 0;
+  virtual auto Name() const -> const char* = 0;
+};
+
+// Returns a nullptr when the epoll instance can't be created.
+auto MakeEpollLoop(Worker& worker) -> std::unique_ptr<EventLoop>;
+// Returns a nullptr when io_uring isn't available at build or run time.
+auto MakeUringLoop(Worker& worker) -> std::unique_ptr<EventLoop>;
+// Returns a nullptr when neither loop can be created.
+auto MakeEventLoop(Worker& worker) -> std::unique_ptr<EventLoop>;
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_EVENT_LOOP_H
+)tmpl"};
+
+constexpr std::string_view kServerHeader{R"tmpl(#ifndef @GUARD@_SERVER_H
+#define @GUARD@_SERVER_H
+
+#include <cstdint>
+
+namespace @NS@ {
+
+struct ServerOptions {
+  uint16_t port{7070};
+  // Number of worker threads, 0 uses one worker per hardware thread.
+  unsigned threads{0};
+};
+
+// Accepts connections until SIGINT or SIGTERM is received, then stops the
+// workers and waits for them to close their connections.
+auto RunServer(const ServerOptions& options) -> int;
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_SERVER_H
+)tmpl"};
+
+constexpr std::string_view kServerSource{R"tmpl(#include "@NAME@/server.h"
+
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "@NAME@/event_loop.h"
+
+namespace @NS@ {
+
+auto Worker::Init() -> bool {
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake_fd_ < 0) {
+    std::perror("eventfd");
+    return false;
+  }
+  return true;
+}
+
+Worker::~Worker() {
+  while (const auto fd = incoming_.TryPop()) {
+    close(*fd);
+  }
+  if (wake_fd_ >= 0) {
+    close(wake_fd_);
+  }
+}
+
+auto Worker::Post(int fd) -> bool {
+  if (!incoming_.TryPush(fd)) {
+    return false;
+  }
+  Wake();
+  return true;
+}
+
+auto Worker::Stop() -> void {
+  stop_.store(true, std::memory_order_release);
+  Wake();
+}
+
+auto Worker::Wake() -> void {
+  const uint64_t one{1};
+  [[maybe_unused]] const auto rv = write(wake_fd_, &one, sizeof(one));
+}
+
+auto MakeEventLoop(Worker& worker) -> std::unique_ptr<EventLoop> {
+  if (auto loop = MakeUringLoop(worker); loop) {
+    return loop;
+  }
+  return MakeEpollLoop(worker);
+}
+
+namespace {
+
+auto PinToCore(unsigned core) -> void {
+  const auto cores = std::thread::hardware_concurrency();
+  if (cores == 0) {
+    return;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(core % cores, &set);
+  pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+auto Listen(uint16_t port) -> int {
+  const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    std::perror("socket");
+    return -1;
+  }
+  const int enable{1};
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_ANY);
+  address.sin_port = htons(port);
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(fd, SOMAXCONN) != 0) {
+    std::perror("bind/listen");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// Hands a connection to the next worker with room in its queue. Returns
+// false when every queue is full, in which case the connection is dropped.
+auto Dispatch(std::vector<std::unique_ptr<Worker>>& workers, std::size_t& next,
+              int fd) -> bool {
+  for (std::size_t i{0}; i < workers.size(); ++i) {
+    auto& worker = workers[next];
+    next = (next + 1) % workers.size();
+    if (worker->Post(fd)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto AcceptAll(int listen_fd, std::vector<std::unique_ptr<Worker>>& workers,
+               std::size_t& next) -> void {
+  while (true) {
+    const int fd = accept4(listen_fd, nullptr, nullptr,
+                           SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    const int enable{1};
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    if (!Dispatch(workers, next, fd)) {
+      close(fd);
+    }
+  }
+}
+
+}  // namespace
+
+auto RunServer(const ServerOptions& options) -> int {
+  // Termination signals are blocked in every thread and read from a signalfd
+  // by the acceptor, so shutdown happens at a well defined point of the loop.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  const int signal_fd = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (signal_fd < 0) {
+    std::perror("signalfd");
+  }
+  const int listen_fd = signal_fd < 0 ? -1 : Listen(options.port);
+  const int epoll_fd = listen_fd < 0 ? -1 : epoll_create1(EPOLL_CLOEXEC);
+  if (listen_fd >= 0 && epoll_fd < 0) {
+    std::perror("epoll_create1");
+  }
+  const auto close_all = [&] {
+    for (const int fd : {epoll_fd, listen_fd, signal_fd}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  };
+  if (signal_fd < 0 || listen_fd < 0 || epoll_fd < 0) {
+    close_all();
+    return EXIT_FAILURE;
+  }
+  for (const int fd : {signal_fd, listen_fd}) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+      std::perror("epoll_ctl");
+      close_all();
+      return EXIT_FAILURE;
+    }
+  }
+
+  auto count = options.threads;
+  if (count == 0) {
+    count = std::max(1U, std::thread::hardware_concurrency());
+  }
+  std::vector<std::unique_ptr<Worker>> workers;
+  std::vector<std::thread> threads;
+  for (unsigned i{0}; i < count; ++i) {
+    workers.push_back(std::make_unique<Worker>(i));
+    if (!workers.back()->Init()) {
+      close_all();
+      return EXIT_FAILURE;
+    }
+  }
+  // Every worker reports whether its loop could be created; the server only
+  // starts accepting when all of them run, so no connection is posted to a
+  // worker that would never serve it.
+  std::vector<std::future<bool>> started;
+  for (auto& worker : workers) {
+    std::promise<bool> promise;
+    started.push_back(promise.get_future());
+    threads.emplace_back(
+        [ptr = worker.get(), promise = std::move(promise)]() mutable {
+          PinToCore(ptr->Id());
+          auto loop = MakeEventLoop(*ptr);
+          promise.set_value(loop != nullptr);
+          if (loop == nullptr) {
+            return;
+          }
+          if (ptr->Id() == 0) {
+            std::fprintf(stderr, "event loop: %s\n", loop->Name());
+          }
+          loop->Run();
+        });
+  }
+  bool all_started{true};
+  for (auto& future : started) {
+    all_started = future.get() && all_started;
+  }
+  if (!all_started) {
+    std::fprintf(stderr, "failed to create the event loops\n");
+    for (auto& worker : workers) {
+      worker->Stop();
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    close_all();
+    return EXIT_FAILURE;
+  }
+  std::fprintf(stderr, "listening on port %u with %u workers\n",
+               static_cast<unsigned>(options.port), count);
+
+  std::size_t next{0};
+  bool running{true};
+  std::array<epoll_event, 16> events{};
+  while (running) {
+    const int n = epoll_wait(epoll_fd, events.data(),
+                             static_cast<int>(events.size()), -1);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      std::perror("epoll_wait");
+      break;
+    }
+    for (int i{0}; i < n; ++i) {
+      if (events[i].data.fd == signal_fd) {
+        signalfd_siginfo info{};
+        [[maybe_unused]] const auto rv = read(signal_fd, &info, sizeof(info));
+        running = false;
+      } else {
+        AcceptAll(listen_fd, workers, next);
+      }
+    }
+  }
+
+  std::fprintf(stderr, "shutting down\n");
+  close(listen_fd);
+  for (auto& worker : workers) {
+    worker->Stop();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  close(epoll_fd);
+  close(signal_fd);
+  return EXIT_SUCCESS;
+}
+
+}  // namespace @NS@
+)tmpl"};
+
+constexpr std::string_view kEpollLoopSource{R"tmpl(#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <unordered_map>
+
+#include "@NAME@/event_loop.h"
+
+namespace @NS@ {
+namespace {
+
+struct Connection {
+  int fd{-1};
+  std::size_t offset{0};
+  std::size_t size{0};
+  bool writing{false};
+  std::array<char, kBufferSize> buffer{};
+};
+
+// Level-triggered epoll loop. A connection is either waiting for input or
+// waiting to flush the rest of its last echo, never both.
+class EpollLoop final : public EventLoop {
+ public:
+  explicit EpollLoop(Worker& worker) : worker_{worker} {}
+
+  ~EpollLoop() override {
+    for (const auto& [fd, connection] : connections_) {
+      close(fd);
+    }
+    if (epoll_fd_ >= 0) {
+      close(epoll_fd_);
+    }
+  }
+
+  EpollLoop(const EpollLoop&) = delete;
+  auto operator=(const EpollLoop&) -> EpollLoop& = delete;
+
+  auto Init() -> bool {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      std::perror("epoll_create1");
+      return false;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, worker_.WakeFd(), &event) != 0) {
+      std::perror("epoll_ctl");
+      return false;
+    }
+    return true;
+  }
+
+  auto Run() -> void override {
+    std::array<epoll_event, 256> events{};
+    while (!worker_.Stopping()) {
+      const int n = epoll_wait(epoll_fd_, events.data(),
+                               static_cast<int>(events.size()), -1);
+      if (n < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      for (int i{0}; i < n; ++i) {
+        auto* connection = static_cast<Connection*>(events[i].data.ptr);
+        if (connection == nullptr) {
+          Wake();
+        } else {
+          Handle(connection, events[i].events);
+        }
+      }
+    }
+  }
+
+  auto Name() const -> const char* override { return "epoll"; }
+
+ private:
+  auto Wake() -> void {
+    uint64_t value{0};
+    [[maybe_unused]] const auto rv = read(worker_.WakeFd(), &value,
+                                          sizeof(value));
+    while (const auto fd = worker_.TakeIncoming()) {
+      auto connection = std::make_unique<Connection>();
+      connection->fd = *fd;
+      epoll_event event{};
+      event.events = EPOLLIN;
+      event.data.ptr = connection.get();
+      if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, *fd, &event) != 0) {
+        close(*fd);
+        continue;
+      }
+      connections_.emplace(*fd, std::move(connection));
+    }
+  }
+
+  auto Handle(Connection* connection, uint32_t events) -> void {
+    if ((events & (EPOLLHUP | EPOLLERR)) != 0) {
+      Close(connection);
+      return;
+    }
+    if ((events & EPOLLOUT) != 0) {
+      Flush(connection);
+      return;
+    }
+    const auto n = recv(connection->fd, connection->buffer.data(),
+                        connection->buffer.size(), 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+      Close(connection);
+      return;
+    }
+    if (n > 0) {
+      connection->offset = 0;
+      connection->size = static_cast<std::size_t>(n);
+      Flush(connection);
+    }
+  }
+
+  auto Flush(Connection* connection) -> void {
+    while (connection->offset < connection->size) {
+      const auto n = send(connection->fd,
+                          connection->buffer.data() + connection->offset,
+                          connection->size - connection->offset, MSG_NOSIGNAL);
+      if (n < 0) {
+        if (errno == EAGAIN) {
+          Watch(connection, true);
+          return;
+        }
+        if (errno == EINTR) {
+          continue;
+        }
+        Close(connection);
+        return;
+      }
+      connection->offset += static_cast<std::size_t>(n);
+    }
+    Watch(connection, false);
+  }
+
+  // Switches between waiting for input and waiting for room to write.
+  auto Watch(Connection* connection, bool writing) -> void {
+    if (connection->writing == writing) {
+      return;
+    }
+    connection->writing = writing;
+    epoll_event event{};
+    event.events = writing ? EPOLLOUT : EPOLLIN;
+    event.data.ptr = connection;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, connection->fd, &event);
+  }
+
+  auto Close(Connection* connection) -> void {
+    const int fd = connection->fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections_.erase(fd);
+  }
+
+  Worker& worker_;
+  int epoll_fd_{-1};
+  std::unordered_map<int, std::unique_ptr<Connection>> connections_;
+};
+
+}  // namespace
+
+auto MakeEpollLoop(Worker& worker) -> std::unique_ptr<EventLoop> {
+  auto loop = std::make_unique<EpollLoop>(worker);
+  if (!loop->Init()) {
+    return nullptr;
+  }
+  return loop;
+}
+
+}  // namespace @NS@
+)tmpl"};
+
+constexpr std::string_view kUringLoopSource{R"tmpl(#include <memory>
+
+#include "@NAME@/event_loop.h"
+
+#ifdef HAVE_LIBURING
+
+#include <liburing.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+namespace @NS@ {
+namespace {
+
+enum class Operation : uint8_t { kWake, kRecv, kSend };
+
+// Every submission carries a pointer to one of these. A connection has at most
+// one operation in flight because the echo protocol alternates recv and send.
+struct Request {
+  Operation operation{Operation::kRecv};
+  int fd{-1};
+  std::size_t offset{0};
+  std::size_t size{0};
+  uint64_t wake_value{0};
+  std::array<char, kBufferSize> buffer{};
+};
+
+class UringLoop final : public EventLoop {
+ public:
+  explicit UringLoop(Worker& worker) : worker_{worker} {
+    wake_.operation = Operation::kWake;
+    wake_.fd = worker_.WakeFd();
+  }
+
+  ~UringLoop() override {
+    for (const auto& [fd, request] : connections_) {
+      close(fd);
+    }
+    if (initialized_) {
+      io_uring_queue_exit(&ring_);
+    }
+  }
+
+  UringLoop(const UringLoop&) = delete;
+  auto operator=(const UringLoop&) -> UringLoop& = delete;
+
+  auto Init() -> bool {
+    initialized_ = io_uring_queue_init(kQueueDepth, &ring_, 0) == 0;
+    return initialized_ && SupportsOperations();
+  }
+
+  auto Run() -> void override {
+    SubmitWake();
+    // After a stop request the sockets are shut down, which completes their
+    // pending operations; the loop ends once all of them have been reaped.
+    while (!stopping_ || !connections_.empty()) {
+      if (io_uring_submit_and_wait(&ring_, 1) < 0) {
+        continue;
+      }
+      io_uring_cqe* cqe{nullptr};
+      unsigned head{0};
+      unsigned seen{0};
+      io_uring_for_each_cqe(&ring_, head, cqe) {
+        ++seen;
+        Complete(static_cast<Request*>(io_uring_cqe_get_data(cqe)), cqe->res);
+      }
+      io_uring_cq_advance(&ring_, seen);
+    }
+  }
+
+  auto Name() const -> const char* override { return "io_uring"; }
+
+ private:
+  static constexpr unsigned kQueueDepth{1024};
+
+  // Kernels before 5.6 have io_uring but complete IORING_OP_READ, RECV and
+  // SEND with -EINVAL, so the loop falls back to epoll there. Those kernels
+  // don't support the probe either.
+  auto SupportsOperations() -> bool {
+    auto* probe = io_uring_get_probe_ring(&ring_);
+    if (probe == nullptr) {
+      return false;
+    }
+    const bool supported{io_uring_opcode_supported(probe, IORING_OP_READ) &&
+                         io_uring_opcode_supported(probe, IORING_OP_RECV) &&
+                         io_uring_opcode_supported(probe, IORING_OP_SEND)};
+    io_uring_free_probe(probe);
+    return supported;
+  }
+
+  auto Sqe() -> io_uring_sqe* {
+    auto* sqe = io_uring_get_sqe(&ring_);
+    while (sqe == nullptr) {
+      io_uring_submit(&ring_);
+      sqe = io_uring_get_sqe(&ring_);
+    }
+    return sqe;
+  }
+
+  auto SubmitWake() -> void {
+    auto* sqe = Sqe();
+    io_uring_prep_read(sqe, wake_.fd, &wake_.wake_value,
+                       sizeof(wake_.wake_value), 0);
+    io_uring_sqe_set_data(sqe, &wake_);
+  }
+
+  auto SubmitRecv(Request* request) -> void {
+    request->operation = Operation::kRecv;
+    auto* sqe = Sqe();
+    io_uring_prep_recv(sqe, request->fd, request->buffer.data(),
+                       request->buffer.size(), 0);
+    io_uring_sqe_set_data(sqe, request);
+  }
+
+  auto SubmitSend(Request* request) -> void {
+    request->operation = Operation::kSend;
+    auto* sqe = Sqe();
+    io_uring_prep_send(sqe, request->fd,
+                       request->buffer.data() + request->offset,
+                       request->size - request->offset, MSG_NOSIGNAL);
+    io_uring_sqe_set_data(sqe, request);
+  }
+
+  auto Complete(Request* request, int result) -> void {
+    switch (request->operation) {
+      case Operation::kWake:
+        Wake();
+        break;
+      case Operation::kRecv:
+        if (result <= 0) {
+          Close(request);
+          break;
+        }
+        request->offset = 0;
+        request->size = static_cast<std::size_t>(result);
+        SubmitSend(request);
+        break;
+      case Operation::kSend:
+        if (result < 0) {
+          Close(request);
+          break;
+        }
+        request->offset += static_cast<std::size_t>(result);
+        if (request->offset < request->size) {
+          SubmitSend(request);
+        } else {
+          SubmitRecv(request);
+        }
+        break;
+    }
+  }
+
+  auto Wake() -> void {
+    while (const auto fd = worker_.TakeIncoming()) {
+      if (stopping_) {
+        close(*fd);
+        continue;
+      }
+      auto request = std::make_unique<Request>();
+      request->fd = *fd;
+      SubmitRecv(request.get());
+      connections_.emplace(*fd, std::move(request));
+    }
+    if (worker_.Stopping() && !stopping_) {
+      stopping_ = true;
+      for (const auto& [fd, request] : connections_) {
+        shutdown(fd, SHUT_RDWR);
+      }
+    }
+    if (!stopping_) {
+      SubmitWake();
+    }
+  }
+
+  auto Close(Request* request) -> void {
+    const int fd = request->fd;
+    close(fd);
+    connections_.erase(fd);
+  }
+
+  Worker& worker_;
+  io_uring ring_{};
+  bool initialized_{false};
+  bool stopping_{false};
+  Request wake_;
+  std::unordered_map<int, std::unique_ptr<Request>> connections_;
+};
+
+}  // namespace
+
+auto MakeUringLoop(Worker& worker) -> std::unique_ptr<EventLoop> {
+  auto loop = std::make_unique<UringLoop>(worker);
+  if (!loop->Init()) {
+    return nullptr;
+  }
+  return loop;
+}
+
+}  // namespace @NS@
+
+#else
+
+namespace @NS@ {
+
+auto MakeUringLoop(Worker& /*worker*/) -> std::unique_ptr<EventLoop> {
+  return nullptr;
+}
+
+}  // namespace @NS@
+
+#endif  // HAVE_LIBURING
+)tmpl"};
+
+constexpr std::string_view kMainSource{R"tmpl(#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+
+@ALLOCATOR_INCLUDE@#include "@NAME@/server.h"
+
+namespace {
+
+template <typename T>
+auto Parse(std::string_view text, T& value) -> bool {
+  const auto* end = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+  return ec == std::errc{} && ptr == end;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+@ALLOCATOR_SETUP@  @NS@::ServerOptions options;
+  for (int i{1}; i < argc; i += 2) {
+    const std::string_view key{argv[i]};
+    const std::string_view value{i + 1 < argc ? argv[i + 1] : ""};
+    bool ok{false};
+    if (key == "--port") {
+      ok = Parse(value, options.port);
+    } else if (key == "--threads") {
+      ok = Parse(value, options.threads);
+    }
+    if (!ok) {
+      std::fprintf(stderr, "usage: %s [--port N] [--threads N]\n", argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+  return @NS@::RunServer(options);
+}
+)tmpl"};
+
+constexpr std::string_view kLoadGeneratorSource{R"tmpl(// Loopback load generator for the echo service. Every thread keeps a set of
+// connections busy with fixed size messages and records the round trip time
+// of each message in a histogram with microsecond buckets.
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+#include <utility>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kHistogramSize{100000};
+// A stalled connection fails after this long, so the stop flag is checked
+// again.
+constexpr timeval kSocketTimeout{1, 0};
+
+struct Options {
+  uint16_t port{7070};
+  unsigned threads{2};
+  unsigned connections{64};
+  unsigned seconds{5};
+  std::size_t size{64};
+};
+
+struct Result {
+  uint64_t messages{0};
+  uint64_t errors{0};
+  std::vector<uint64_t> histogram = std::vector<uint64_t>(kHistogramSize, 0);
+};
+
+template <typename T>
+auto Parse(std::string_view text, T& value) -> bool {
+  const auto* end = text.data() + text.size();
+  const auto [ptr, ec] = std::from_chars(text.data(), end, value);
+  return ec == std::errc{} && ptr == end;
+}
+
+auto Connect(uint16_t port) -> int {
+  const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  sockaddr_in address{};
+  address.sin_family = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  address.sin_port = htons(port);
+  if (fd < 0 ||
+      connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    return -1;
+  }
+  const int enable{1};
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &kSocketTimeout,
+             sizeof(kSocketTimeout));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &kSocketTimeout,
+             sizeof(kSocketTimeout));
+  return fd;
+}
+
+auto SendAll(int fd, const char* data, std::size_t size) -> bool {
+  while (size > 0) {
+    const auto n = send(fd, data, size, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+auto ReceiveAll(int fd, char* data, std::size_t size) -> bool {
+  while (size > 0) {
+    const auto n = recv(fd, data, size, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    // 0 when the peer closed the connection, EAGAIN after the timeout.
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+auto Drive(const Options& options, unsigned connections,
+           const std::atomic<bool>& stop, Result& result) -> void {
+  std::vector<int> fds;
+  for (unsigned i{0}; i < connections; ++i) {
+    if (const int fd = Connect(options.port); fd >= 0) {
+      fds.push_back(fd);
+    } else {
+      ++result.errors;
+    }
+  }
+  std::vector<char> message(options.size, 'x');
+  std::vector<char> reply(options.size);
+  std::vector<Clock::time_point> sent(fds.size());
+  // Closes a failed connection; the loop continues with the others.
+  auto drop = [&](std::size_t i) {
+    ++result.errors;
+    close(fds[i]);
+    fds[i] = -1;
+  };
+  while (!stop.load(std::memory_order_relaxed) && !fds.empty()) {
+    for (std::size_t i{0}; i < fds.size(); ++i) {
+      sent[i] = Clock::now();
+      if (!SendAll(fds[i], message.data(), message.size())) {
+        drop(i);
+      }
+    }
+    for (std::size_t i{0}; i < fds.size(); ++i) {
+      if (fds[i] < 0) {
+        continue;
+      }
+      if (!ReceiveAll(fds[i], reply.data(), reply.size())) {
+        drop(i);
+        continue;
+      }
+      const auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+                          Clock::now() - sent[i])
+                          .count();
+      ++result.histogram[std::min<std::size_t>(us, kHistogramSize - 1)];
+      ++result.messages;
+    }
+    fds.erase(std::remove(fds.begin(), fds.end(), -1), fds.end());
+    sent.resize(fds.size());
+  }
+  for (const int fd : fds) {
+    close(fd);
+  }
+}
+
+auto Percentile(const std::vector<uint64_t>& histogram, uint64_t total,
+                double fraction) -> std::size_t {
+  const auto target = static_cast<uint64_t>(static_cast<double>(total) * fraction);
+  uint64_t seen{0};
+  for (std::size_t us{0}; us < histogram.size(); ++us) {
+    seen += histogram[us];
+    if (seen > target) {
+      return us;
+    }
+  }
+  return histogram.size() - 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i{1}; i < argc; i += 2) {
+    const std::string_view key{argv[i]};
+    const std::string_view value{i + 1 < argc ? argv[i + 1] : ""};
+    bool ok{false};
+    if (key == "--port") {
+      ok = Parse(value, options.port);
+    } else if (key == "--threads") {
+      ok = Parse(value, options.threads);
+    } else if (key == "--connections") {
+      ok = Parse(value, options.connections);
+    } else if (key == "--seconds") {
+      ok = Parse(value, options.seconds);
+    } else if (key == "--size") {
+      ok = Parse(value, options.size);
+    }
+    if (!ok || options.threads == 0 || options.size == 0) {
+      std::fprintf(stderr,
+                   "usage: %s [--port N] [--threads N] [--connections N] "
+                   "[--seconds N] [--size BYTES]\n",
+                   argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::atomic<bool> stop{false};
+  std::vector<Result> results(options.threads);
+  std::vector<std::thread> threads;
+  const auto start = Clock::now();
+  for (unsigned i{0}; i < options.threads; ++i) {
+    const unsigned connections = options.connections / options.threads +
+                                 (i < options.connections % options.threads);
+    threads.emplace_back(Drive, std::cref(options), connections,
+                         std::cref(stop), std::ref(results[i]));
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+  stop.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed = Clock::now() - start;
+
+  Result total;
+  for (const auto& result : results) {
+    total.messages += result.messages;
+    total.errors += result.errors;
+    for (std::size_t us{0}; us < kHistogramSize; ++us) {
+      total.histogram[us] += result.histogram[us];
+    }
+  }
+  std::printf("messages: %llu\nerrors: %llu\nthroughput: %.0f msg/s\n",
+              static_cast<unsigned long long>(total.messages),
+              static_cast<unsigned long long>(total.errors),
+              static_cast<double>(total.messages) / elapsed.count());
+  if (total.messages == 0) {
+    // Without samples every percentile would be the last histogram bucket.
+    std::printf("latency p50: n/a\nlatency p99: n/a\n");
+    return EXIT_FAILURE;
+  }
+  std::printf("latency p50: %zu us\nlatency p99: %zu us\n",
+              Percentile(total.histogram, total.messages, 0.50),
+              Percentile(total.histogram, total.messages, 0.99));
+  return total.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+)tmpl"};
+
+}  // namespace
+
+auto WriteServiceProfile(const std::filesystem::path& project_path,
+                         const AppParams* param) -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteServiceProfile")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteServiceProfile") << "param is a nullptr";
+    return 2;
+  }
+  const auto include_path = project_path / "include" / param->name;
+  const auto src_path = project_path / "src";
+  const auto bench_path = project_path / "bench";
+  std::error_code error_code;
+  std::filesystem::create_directories(bench_path, error_code);
+  if (error_code) {
+    Log(LogLevel::kError, "WriteServiceProfile")
+        .Field("errno", error_code.value())
+        .Field("error", error_code.message())
+        << "failed to create directory: " << bench_path;
+    return 3;
+  }
+
+  auto substitutions = ProjectSubstitutions(param->name, param->cpp_namespace);
+  if (param->allocator_selection) {
+    substitutions.emplace_back(
+        "ALLOCATOR_INCLUDE",
+        "#include \"" + param->name + "/allocator_stats.h\"\n");
+    substitutions.emplace_back(
+        "ALLOCATOR_SETUP",
+        "  " + param->cpp_namespace + "::allocator::DumpStatsAtExit();\n");
+  } else {
+    substitutions.emplace_back("ALLOCATOR_INCLUDE", "");
+    substitutions.emplace_back("ALLOCATOR_SETUP", "");
+  }
+  const std::pair<std::filesystem::path, std::string_view> files[]{
+      {include_path / "spsc_queue.h", kSpscQueueHeader},
+      {include_path / "event_loop.h", kEventLoopHeader},
+      {include_path / "server.h", kServerHeader},
+      {src_path / "server.cpp", kServerSource},
+      {src_path / "event_loop_epoll.cpp", kEpollLoopSource},
+      {src_path / "event_loop_uring.cpp", kUringLoopSource},
+      {src_path / "main.cpp", kMainSource},
+      {bench_path / "loadgen.cpp", kLoadGeneratorSource},
+  };
+  for (const auto& [path, text] : files) {
+    if (WriteTextFile(path, Substitute(text, substitutions)) != 0) {
+      Log(LogLevel::kError, "WriteServiceProfile")
+          << "failed to write " << path;
+      return 4;
+    }
+  }
+  return 0;
+}
+
+}  // namespace ci
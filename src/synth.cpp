@@ -0,0 +1,463 @@
+#include "cpp_init/synth.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "cpp_init/blob_store.h"
+#include "cpp_init/cli.h"
+#include "cpp_init/console.h"
+#include "cpp_init/generator.h"
+#include "cpp_init/log.h"
+#include "cpp_init/params.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+struct SynthOptions {
+  std::filesystem::path out{"."};
+  std::string name{"synth"};
+  uint32_t libraries{100};
+  uint32_t applications{10};
+  // Number of library layers; a library only depends on the layer below.
+  uint32_t depth{5};
+  // Number of dependencies of every library above the first layer and of
+  // every application.
+  uint32_t fanout{3};
+  uint64_t seed{1};
+  uint32_t sources{4};
+  uint32_t functions{20};
+  uint32_t include_depth{3};
+  uint32_t template_percent{20};
+  uint32_t jobs{0};
+  uint8_t cpp_standard{17};
+  // How files shared by the projects are written, std::nullopt writes them
+  // without looking for duplicates.
+  std::optional<LinkMode> dedup;
+};
+
+// A synthetic project and the indices of the libraries it depends on.
+struct SynthProject {
+  std::unique_ptr<CommonParams> param;
+  std::vector<uint32_t> dependencies;
+};
+
+// Integral only: the templates wrap around in the unsigned type, and a double
+// would overflow when the result is converted back to uint64_t.
+constexpr std::string_view kTemplateTypes[]{"uint64_t", "uint32_t", "int64_t",
+                                            "int32_t"};
+
+auto PrintUsage() -> void {
+  ConsoleError(
+      "usage: cpp_init synth [options]\n"
+      "\n"
+      "  --out DIR              output directory (default: .)\n"
+      "  --name NAME            name of the super project (default: synth)\n"
+      "  --libs N               number of libraries (default: 100)\n"
+      "  --apps N               number of applications (default: 10)\n"
+      "  --depth N              number of library layers (default: 5)\n"
+      "  --fanout N             dependencies per target (default: 3)\n"
+      "  --seed N               random seed (default: 1)\n"
+      "  --sources N            sources per library (default: 4)\n"
+      "  --functions N          functions per source (default: 20)\n"
+      "  --include-depth N      headers in each include chain (default: 3)\n"
+      "  --template-percent N   functions using templates (default: 20)\n"
+      "  --cxx-standard N       C++ standard (default: 17)\n"
+      "  --jobs N               writer threads (default: all cores)\n"
+      "  --dedup MODE           write identical files once and copy,\n"
+      "                         reflink or hardlink them (default: off)\n");
+}
+
+auto ParseLinkMode(std::string_view value) -> std::optional<LinkMode> {
+  if (value == "copy") {
+    return LinkMode::kCopy;
+  }
+  if (value == "reflink") {
+    return LinkMode::kReflink;
+  }
+  if (value == "hardlink") {
+    return LinkMode::kHardlink;
+  }
+  return std::nullopt;
+}
+
+auto ParseSynthOptions(const std::vector<std::string_view>& args)
+    -> std::optional<SynthOptions> {
+  SynthOptions options;
+  for (std::size_t i{0}; i < args.size(); i += 2) {
+    if (i + 1 >= args.size()) {
+      return std::nullopt;
+    }
+    const auto key = args[i];
+    const auto value = args[i + 1];
+    bool ok{true};
+    if (key == "--out") {
+      options.out = value;
+    } else if (key == "--name") {
+      options.name = value;
+    } else if (key == "--libs") {
+      ok = ParseNumber(value, options.libraries);
+    } else if (key == "--apps") {
+      ok = ParseNumber(value, options.applications);
+    } else if (key == "--depth") {
+      ok = ParseNumber(value, options.depth);
+    } else if (key == "--fanout") {
+      ok = ParseNumber(value, options.fanout);
+    } else if (key == "--seed") {
+      ok = ParseNumber(value, options.seed);
+    } else if (key == "--sources") {
+      ok = ParseNumber(value, options.sources);
+    } else if (key == "--functions") {
+      ok = ParseNumber(value, options.functions);
+    } else if (key == "--include-depth") {
+      ok = ParseNumber(value, options.include_depth);
+    } else if (key == "--template-percent") {
+      ok = ParseNumber(value, options.template_percent);
+    } else if (key == "--cxx-standard") {
+      ok = ParseNumber(value, options.cpp_standard);
+    } else if (key == "--jobs") {
+      ok = ParseNumber(value, options.jobs);
+    } else if (key == "--dedup") {
+      options.dedup = ParseLinkMode(value);
+      ok = options.dedup.has_value();
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      return std::nullopt;
+    }
+  }
+  if (options.name.empty() || options.libraries == 0 || options.depth == 0 ||
+      options.sources == 0 || options.functions == 0 ||
+      options.include_depth == 0 || options.template_percent > 100) {
+    return std::nullopt;
+  }
+  options.depth = std::min(options.depth, options.libraries);
+  if (options.jobs == 0) {
+    options.jobs = std::max(1U, std::thread::hardware_concurrency());
+  }
+  return options;
+}
+
+auto NumberedName(std::string_view prefix, uint32_t index, uint32_t count)
+    -> std::string {
+  auto digits = std::to_string(count > 0 ? count - 1 : 0);
+  auto number = std::to_string(index);
+  std::string name{prefix};
+  name.append(digits.size() - number.size(), '0');
+  name.append(number);
+  return name;
+}
+
+// Random picks of up to fanout distinct libraries in [begin, end).
+auto PickDependencies(std::mt19937_64& rng, uint32_t begin, uint32_t end,
+                      uint32_t fanout) -> std::vector<uint32_t> {
+  std::vector<uint32_t> candidates;
+  for (auto i = begin; i < end; ++i) {
+    candidates.push_back(i);
+  }
+  std::shuffle(candidates.begin(), candidates.end(), rng);
+  candidates.resize(std::min<std::size_t>(fanout, candidates.size()));
+  std::sort(candidates.begin(), candidates.end());
+  return candidates;
+}
+
+// Libraries are split evenly over the layers, layer l has the libraries
+// [LayerBegin(l), LayerBegin(l + 1)).
+auto LayerBegin(const SynthOptions& options, uint32_t layer) -> uint32_t {
+  return static_cast<uint32_t>(static_cast<uint64_t>(layer) *
+                               options.libraries / options.depth);
+}
+
+auto BuildGraph(const SynthOptions& options, SuperProjectParams* super)
+    -> std::vector<SynthProject> {
+  std::mt19937_64 rng{options.seed};
+  std::vector<SynthProject> projects;
+  projects.reserve(options.libraries + options.applications);
+  for (uint32_t layer{0}; layer < options.depth; ++layer) {
+    const auto begin = LayerBegin(options, layer);
+    const auto end = LayerBegin(options, layer + 1);
+    for (auto i = begin; i < end; ++i) {
+      auto param = std::make_unique<LibraryParams>();
+      param->name = NumberedName("lib", i, options.libraries);
+      param->alias = param->name;
+      param->cmake_namespace = options.name;
+      param->cpp_namespace = param->name;
+      param->cpp_standard = options.cpp_standard;
+      SynthProject project;
+      if (layer > 0) {
+        project.dependencies = PickDependencies(
+            rng, LayerBegin(options, layer - 1), begin, options.fanout);
+      }
+      super->Add(param.get());
+      project.param = std::move(param);
+      projects.push_back(std::move(project));
+    }
+  }
+  const auto top = LayerBegin(options, options.depth - 1);
+  for (uint32_t i{0}; i < options.applications; ++i) {
+    auto param = std::make_unique<AppParams>();
+    param->name = NumberedName("app", i, options.applications);
+    param->output_name = param->name;
+    param->cmake_namespace = options.name;
+    param->cpp_namespace = param->name;
+    param->cpp_standard = options.cpp_standard;
+    SynthProject project;
+    project.dependencies =
+        PickDependencies(rng, top, options.libraries, options.fanout);
+    super->Add(param.get());
+    project.param = std::move(param);
+    projects.push_back(std::move(project));
+  }
+  return projects;
+}
+
+auto TemplatesPerHeader(const SynthOptions& options) -> uint32_t {
+  if (options.template_percent == 0) {
+    return 0;
+  }
+  return std::max(1U, options.functions * options.template_percent / 100);
+}
+
+// Header j of a library includes header j + 1; the last header of the chain
+// includes the first header of every dependency. h0.h declares the functions
+// of the library.
+auto SynthHeader(const SynthOptions& options,
+                 const std::vector<SynthProject>& projects,
+                 const SynthProject& project, uint32_t j) -> std::string {
+  const auto& name = project.param->name;
+  const auto guard = ToUpperIdentifier(name) + "_H" + std::to_string(j) + "_H";
+  std::string text;
+  text.reserve(1024 + 128 * (options.functions * options.sources +
+                             TemplatesPerHeader(options)));
+  text += "#ifndef " + guard + "\n#define " + guard + "\n\n";
+  text += "#include <cstdint>\n#include <type_traits>\n\n";
+  if (j + 1 < options.include_depth) {
+    text += "#include \"" + name + "/h" + std::to_string(j + 1) + ".h\"\n";
+  } else {
+    for (const auto dependency : project.dependencies) {
+      text += "#include \"" + projects[dependency].param->name + "/h0.h\"\n";
+    }
+  }
+  text += "\nnamespace " + name + " {\n\n";
+  const auto templates = TemplatesPerHeader(options);
+  for (uint32_t k{0}; k < templates; ++k) {
+    const auto id = std::to_string(j) + "_" + std::to_string(k);
+    text += "template <typename T>\nauto t" + id + "(T x) -> T {\n";
+    text += "  using U = std::make_unsigned_t<T>;\n";
+    text += "  U acc = static_cast<U>(x);\n";
+    text += "  for (U i = 0; i < " + std::to_string(3 + k % 7) + "U; ++i) {\n";
+    text += "    acc = static_cast<U>(acc * 31U + i);\n  }\n";
+    text += "  return static_cast<T>(acc);\n}\n\n";
+  }
+  if (j == 0) {
+    for (uint32_t s{0}; s < options.sources; ++s) {
+      for (uint32_t f{0}; f < options.functions; ++f) {
+        text += "auto f" + std::to_string(s) + "_" + std::to_string(f) +
+                "(uint64_t x) -> uint64_t;\n";
+      }
+    }
+  }
+  text += "\n}  // namespace " + name + "\n\n#endif  // " + guard + "\n";
+  return text;
+}
+
+auto SynthSource(const SynthOptions& options,
+                 const std::vector<SynthProject>& projects,
+                 const SynthProject& project, uint32_t s, std::mt19937_64& rng)
+    -> std::string {
+  const auto& name = project.param->name;
+  const auto templates = TemplatesPerHeader(options);
+  std::string text;
+  text.reserve(256 + 256 * options.functions);
+  text += "#include \"" + name + "/h0.h\"\n\nnamespace " + name + " {\n";
+  for (uint32_t f{0}; f < options.functions; ++f) {
+    text += "\nauto f" + std::to_string(s) + "_" + std::to_string(f) +
+            "(uint64_t x) -> uint64_t {\n";
+    text += "  uint64_t acc = x + " + std::to_string(f) + "U;\n";
+    text += "  for (uint64_t i = 0; i < 8; ++i) {\n";
+    text += "    acc = acc * 6364136223846793005U + i;\n  }\n";
+    if (templates > 0 && rng() % 100 < options.template_percent) {
+      const auto j = rng() % options.include_depth;
+      const auto k = rng() % templates;
+      const auto type = kTemplateTypes[rng() % std::size(kTemplateTypes)];
+      text += "  acc += static_cast<uint64_t>(t" + std::to_string(j) + "_" +
+              std::to_string(k) + "<" + std::string{type} +
+              ">(static_cast<" + std::string{type} + ">(acc)));\n";
+    }
+    if (s == 0 && f == 0) {
+      for (const auto dependency : project.dependencies) {
+        text += "  acc += " + projects[dependency].param->name + "::f0_0(acc);\n";
+      }
+    }
+    text += "  return acc;\n}\n";
+  }
+  text += "\n}  // namespace " + name + "\n";
+  return text;
+}
+
+auto SynthMain(const std::vector<SynthProject>& projects,
+               const SynthProject& project) -> std::string {
+  std::string text{"#include <cstdint>\n#include <cstdlib>\n\n"};
+  for (const auto dependency : project.dependencies) {
+    text += "#include \"" + projects[dependency].param->name + "/h0.h\"\n";
+  }
+  text += "\nint main(int argc, char** argv) {\n";
+  text += "  uint64_t acc = static_cast<uint64_t>(argc);\n";
+  for (const auto dependency : project.dependencies) {
+    text += "  acc += " + projects[dependency].param->name + "::f0_0(acc);\n";
+  }
+  text += "  return acc == 0 ? EXIT_FAILURE : EXIT_SUCCESS;\n}\n";
+  return text;
+}
+
+// Registers the synthetic files of a project in its params, so the generated
+// CMakeLists lists them, and the dependencies as link libraries.
+auto DescribeProject(const SynthOptions& options,
+                     const std::vector<SynthProject>& projects,
+                     SynthProject& project) -> void {
+  auto* param = project.param.get();
+  for (const auto dependency : project.dependencies) {
+    const auto& lib = projects[dependency].param->name;
+    param->libraries.push_back(options.name + "::" + lib);
+  }
+  if (!param->IsLibrary()) {
+    return;
+  }
+  for (uint32_t j{0}; j < options.include_depth; ++j) {
+    param->headers.push_back("include/" + param->name + "/h" +
+                             std::to_string(j) + ".h");
+  }
+  for (uint32_t s{0}; s < options.sources; ++s) {
+    param->sources.push_back("src/s" + std::to_string(s) + ".cpp");
+  }
+}
+
+auto WriteProject(const SynthOptions& options,
+                  const std::vector<SynthProject>& projects, uint32_t index,
+                  const std::filesystem::path& super_path,
+                  const SuperProjectParams* super, BlobStore* store)
+    -> int32_t {
+  const auto& project = projects[index];
+  auto* param = project.param.get();
+  if (const auto rv = GenerateProject(super_path, param, super, store);
+      rv != 0) {
+    return rv;
+  }
+  const auto project_path = super_path / param->name;
+  if (param->IsApplication()) {
+    return WriteTextFile(project_path / "src" / "main.cpp",
+                         SynthMain(projects, project));
+  }
+  // Every library has its own generator, so the output doesn't depend on the
+  // order in which the threads pick up the projects.
+  std::mt19937_64 rng{options.seed ^ (0x9E3779B97F4A7C15ULL * (index + 1))};
+  for (uint32_t j{0}; j < options.include_depth; ++j) {
+    const auto path = project_path / "include" / param->name /
+                      ("h" + std::to_string(j) + ".h");
+    if (const auto rv =
+            WriteTextFile(path, SynthHeader(options, projects, project, j));
+        rv != 0) {
+      return rv;
+    }
+  }
+  for (uint32_t s{0}; s < options.sources; ++s) {
+    const auto path = project_path / "src" / ("s" + std::to_string(s) + ".cpp");
+    if (const auto rv = WriteTextFile(
+            path, SynthSource(options, projects, project, s, rng));
+        rv != 0) {
+      return rv;
+    }
+  }
+  return 0;
+}
+
+}  // namespace
+
+auto RunSynth(const std::vector<std::string_view>& args) -> int32_t {
+  const auto options = ParseSynthOptions(args);
+  if (!options) {
+    PrintUsage();
+    return 1;
+  }
+  const auto start = std::chrono::steady_clock::now();
+  std::error_code error_code;
+  std::filesystem::create_directories(options->out, error_code);
+  if (error_code) {
+    Log(LogLevel::kError, "RunSynth")
+        .Field("errno", error_code.value())
+        .Field("error", error_code.message())
+        << "failed to create directory: " << options->out;
+    return 2;
+  }
+
+  SuperProjectParams super;
+  super.name = options->name;
+  auto projects = BuildGraph(*options, &super);
+  for (auto& project : projects) {
+    DescribeProject(*options, projects, project);
+  }
+  std::unique_ptr<BlobStore> store;
+  if (options->dedup) {
+    store = std::make_unique<BlobStore>(*options->dedup);
+  }
+  if (const auto rv =
+          GenerateProject(options->out, &super, nullptr, store.get());
+      rv != 0) {
+    Log(LogLevel::kError, "RunSynth") << "failed to generate " << super.name;
+    return 3;
+  }
+
+  const auto super_path = options->out / super.name;
+  std::atomic<uint32_t> next{0};
+  std::atomic<bool> failed{false};
+  const auto count = static_cast<uint32_t>(projects.size());
+  auto worker = [&] {
+    for (auto i = next.fetch_add(1); i < count && !failed.load();
+         i = next.fetch_add(1)) {
+      if (WriteProject(*options, projects, i, super_path, &super,
+                       store.get()) != 0) {
+        Log(LogLevel::kError, "RunSynth") << "failed to generate "
+                                          << projects[i].param->name;
+        failed.store(true);
+      }
+    }
+  };
+  std::vector<std::thread> threads;
+  for (uint32_t i{1}; i < options->jobs; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  if (failed.load()) {
+    return 4;
+  }
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  Log(LogLevel::kInfo, "synth") << options->libraries << " libraries and "
+                                << options->applications << " applications in "
+                                << super_path << " (" << elapsed.count()
+                                << " ms)";
+  if (store) {
+    const auto stats = store->Stats();
+    Log(LogLevel::kInfo, "synth") << stats.files << " shared files, "
+                                  << stats.blobs << " blobs, " << stats.reflinks
+                                  << " reflinks, " << stats.hardlinks
+                                  << " hardlinks, " << stats.copies
+                                  << " copies, " << stats.bytes_saved
+                                  << " bytes saved";
+  }
+  return 0;
+}
+
+}  // namespace ci
@@ -0,0 +1,217 @@
+#include "cpp_init/template_scaffolding.h"
+
+#include <string_view>
+#include <utility>
+
+#include "cpp_init/log.h"
+#include "cpp_init/text_file.h"
+
+namespace ci {
+namespace {
+
+constexpr std::string_view kForwardHeader{R"tmpl(#ifndef @GUARD@_@UPPER@_FWD_H
+#define @GUARD@_@UPPER@_FWD_H
+
+// Forward declarations. Include this header instead of @NAME@.h where only
+// names are needed (pointers, references, function declarations).
+
+namespace @NS@ {
+
+template <typename T>
+class Statistics;
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_@UPPER@_FWD_H
+)tmpl"};
+
+constexpr std::string_view kHeader{R"tmpl(#ifndef @GUARD@_@UPPER@_H
+#define @GUARD@_@UPPER@_H
+
+// Class template declarations. Member definitions live in @NAME@_impl.h and
+// are compiled once for the types listed below in src/instantiations.cpp;
+// other translation units only see the declarations and link against those
+// instantiations. Keep this header free of heavy includes, the allowlist is
+// enforced by check_public_headers() in CMakeLists.txt.
+
+#include <cstddef>
+
+#include "@NAME@/@NAME@_fwd.h"
+
+namespace @NS@ {
+
+// Running count, mean and variance (Welford's algorithm).
+template <typename T>
+class Statistics {
+ public:
+  auto Add(T value) -> void;
+  auto Count() const -> std::size_t { return count_; }
+  auto Mean() const -> T { return mean_; }
+  auto Variance() const -> T;
+  auto StandardDeviation() const -> T;
+
+ private:
+  std::size_t count_{0};
+  T mean_{};
+  T m2_{};
+};
+
+extern template class Statistics<float>;
+extern template class Statistics<double>;
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_@UPPER@_H
+)tmpl"};
+
+constexpr std::string_view kImplHeader{R"tmpl(#ifndef @GUARD@_@UPPER@_IMPL_H
+#define @GUARD@_@UPPER@_IMPL_H
+
+// Member definitions of the templates in @NAME@.h. Only include this header
+// to instantiate the templates for types that aren't instantiated in
+// src/instantiations.cpp.
+
+#include <cmath>
+
+#include "@NAME@/@NAME@.h"
+
+namespace @NS@ {
+
+template <typename T>
+auto Statistics<T>::Add(T value) -> void {
+  ++count_;
+  const T delta = value - mean_;
+  mean_ += delta / static_cast<T>(count_);
+  m2_ += delta * (value - mean_);
+}
+
+template <typename T>
+auto Statistics<T>::Variance() const -> T {
+  return count_ < 2 ? T{} : m2_ / static_cast<T>(count_ - 1);
+}
+
+template <typename T>
+auto Statistics<T>::StandardDeviation() const -> T {
+  return std::sqrt(Variance());
+}
+
+}  // namespace @NS@
+
+#endif  // @GUARD@_@UPPER@_IMPL_H
+)tmpl"};
+
+constexpr std::string_view kInstantiationsSource{R"tmpl(// Explicit instantiations of the templates in @NAME@.h. Every type listed here
+// needs a matching extern template declaration in the header.
+#include "@NAME@/@NAME@_impl.h"
+
+namespace @NS@ {
+
+template class Statistics<float>;
+template class Statistics<double>;
+
+}  // namespace @NS@
+)tmpl"};
+
+constexpr std::string_view kPublicHeaderCheckCmake{R"tmpl(# check_public_headers(INCLUDE_DIR <dir> HEADERS <header>... ALLOWED <name>...)
+#
+# Fails the configure step when one of the headers, or a project header it
+# includes with quotes, includes a <...> header that isn't in ALLOWED. Every
+# header included by a public header is compiled again by each translation unit
+# of each consumer, so heavy headers belong in *_impl.h or in the sources.
+function(check_public_headers)
+    cmake_parse_arguments(CHECK "" "INCLUDE_DIR" "HEADERS;ALLOWED" ${ARGN})
+    set(pending)
+    foreach (header IN LISTS CHECK_HEADERS)
+        get_filename_component(header ${header} ABSOLUTE)
+        list(APPEND pending ${header})
+    endforeach ()
+    set(visited)
+    set(violations)
+    while (pending)
+        list(POP_FRONT pending header)
+        if (header IN_LIST visited)
+            continue()
+        endif ()
+        list(APPEND visited ${header})
+        set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${header})
+        get_filename_component(header_dir ${header} DIRECTORY)
+        file(STRINGS ${header} lines REGEX "^[ \t]*#[ \t]*include")
+        foreach (line IN LISTS lines)
+            if (line MATCHES "<([^>]+)>")
+                if (NOT CMAKE_MATCH_1 IN_LIST CHECK_ALLOWED)
+                    list(APPEND violations "${header}: <${CMAKE_MATCH_1}>")
+                endif ()
+            elseif (line MATCHES "\"([^\"]+)\"")
+                set(name ${CMAKE_MATCH_1})
+                foreach (dir ${header_dir} ${CHECK_INCLUDE_DIR})
+                    if (EXISTS ${dir}/${name})
+                        get_filename_component(path ${dir}/${name} ABSOLUTE)
+                        list(APPEND pending ${path})
+                        break()
+                    endif ()
+                endforeach ()
+            endif ()
+        endforeach ()
+    endwhile ()
+    if (violations)
+        list(JOIN violations "\n  " message)
+        message(FATAL_ERROR
+                "Public headers include headers outside the allowlist:\n"
+                "  ${message}\n"
+                "Move the include to an *_impl.h header or a source file, or "
+                "add it to ALLOWED.")
+    endif ()
+endfunction()
+)tmpl"};
+
+}  // namespace
+
+auto PublicHeaderAllowlist() -> std::vector<std::string_view> {
+  return {"cstddef", "cstdint", "initializer_list", "limits", "type_traits",
+          "utility"};
+}
+
+auto WriteTemplateScaffolding(const std::filesystem::path& project_path,
+                              const LibraryParams* param) -> uint8_t {
+  if (!is_directory(project_path)) {
+    Log(LogLevel::kError, "WriteTemplateScaffolding")
+        << "project directory doesn't exist";
+    return 1;
+  }
+  if (param == nullptr) {
+    Log(LogLevel::kError, "WriteTemplateScaffolding") << "param is a nullptr";
+    return 2;
+  }
+  // Sub projects don't have a cmake directory of their own by default.
+  const auto cmake_path = project_path / "cmake";
+  std::error_code error_code;
+  std::filesystem::create_directories(cmake_path, error_code);
+  if (error_code) {
+    Log(LogLevel::kError, "WriteTemplateScaffolding")
+        .Field("errno", error_code.value())
+        .Field("error", error_code.message())
+        << "failed to create directory: " << cmake_path;
+    return 3;
+  }
+
+  const auto substitutions =
+      ProjectSubstitutions(param->name, param->cpp_namespace);
+  const auto include_path = project_path / "include" / param->name;
+  const std::pair<std::filesystem::path, std::string_view> files[]{
+      {include_path / (param->name + "_fwd.h"), kForwardHeader},
+      {include_path / (param->name + ".h"), kHeader},
+      {include_path / (param->name + "_impl.h"), kImplHeader},
+      {project_path / "src" / "instantiations.cpp", kInstantiationsSource},
+      {cmake_path / "public_header_check.cmake", kPublicHeaderCheckCmake},
+  };
+  for (const auto& [path, text] : files) {
+    if (WriteTextFile(path, Substitute(text, substitutions)) != 0) {
+      Log(LogLevel::kError, "WriteTemplateScaffolding") << "failed to write "
+                                                        << path;
+      return 4;
+    }
+  }
+  return 0;
+}
+
+}  // namespace ci
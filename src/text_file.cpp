@@ -0,0 +1,85 @@
+#include "cpp_init/text_file.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+
+#include "cpp_init/log.h"
+
+namespace ci {
+
+auto Substitute(std::string_view text, const Substitutions& substitutions)
+    -> std::string {
+  std::string result;
+  result.reserve(text.size());
+  std::size_t pos{0};
+  while (pos < text.size()) {
+    const auto begin = text.find('@', pos);
+    if (begin == std::string_view::npos) {
+      break;
+    }
+    const auto end = text.find('@', begin + 1);
+    if (end == std::string_view::npos) {
+      break;
+    }
+    const auto key = text.substr(begin + 1, end - begin - 1);
+    const auto it = std::find_if(
+        substitutions.cbegin(), substitutions.cend(),
+        [key](const auto& substitution) { return substitution.first == key; });
+    if (it == substitutions.cend()) {
+      result.append(text.substr(pos, end - pos));
+      pos = end;
+      continue;
+    }
+    result.append(text.substr(pos, begin - pos));
+    result.append(it->second);
+    pos = end + 1;
+  }
+  result.append(text.substr(pos));
+  return result;
+}
+
+auto ToUpperIdentifier(std::string_view name) -> std::string {
+  std::string upper;
+  upper.reserve(name.size());
+  for (const auto c : name) {
+    const auto uc = static_cast<unsigned char>(c);
+    upper.push_back(std::isalnum(uc) != 0 ? static_cast<char>(std::toupper(uc))
+                                          : '_');
+  }
+  return upper;
+}
+
+auto ProjectSubstitutions(std::string_view name, std::string_view cpp_namespace)
+    -> Substitutions {
+  const auto upper = ToUpperIdentifier(name);
+  return {
+      {"NAME", std::string{name}},
+      {"NS", std::string{cpp_namespace}},
+      {"UPPER", upper},
+      {"GUARD", upper + "_INCLUDE_" + upper},
+  };
+}
+
+auto WriteTextFile(const std::filesystem::path& path, std::string_view content)
+    -> uint8_t {
+  if (!is_directory(path.parent_path())) {
+    Log(LogLevel::kError, "WriteTextFile") << "directory doesn't exist: "
+                                           << path.parent_path();
+    return 1;
+  }
+  std::ofstream out(path.string(), std::ios_base::out | std::ios_base::binary);
+  if (!out.is_open()) {
+    Log(LogLevel::kError, "WriteTextFile") << "failed to open " << path;
+    return 2;
+  }
+  out.write(content.data(), static_cast<std::streamsize>(content.size()));
+  out.close();
+  if (out.is_open() || out.fail()) {
+    Log(LogLevel::kError, "WriteTextFile") << "failed to write " << path;
+    return 3;
+  }
+  return 0;
+}
+
+}  // namespace ci
@@ -0,0 +1,75 @@
+// Checks that projects are raised to the C++ standard their features need.
+
+#include <cstdio>
+#include <cstdlib>
+
+#include "cpp_init/params.h"
+
+namespace {
+
+int failures{0};
+
+auto Expect(bool condition, const char* what) -> void {
+  if (!condition) {
+    std::fprintf(stderr, "FAILED: %s\n", what);
+    ++failures;
+  }
+}
+
+}  // namespace
+
+int main() {
+  {
+    ci::AppParams app;
+    app.cpp_standard = 17;
+    app.embed_resources = true;
+    Expect(ci::RaiseCppStandard(&app), "resources raise C++17");
+    Expect(app.cpp_standard == 20, "resources need C++20");
+  }
+  {
+    ci::AppParams app;
+    app.cpp_standard = 14;
+    app.profile = ci::AppProfile::kService;
+    Expect(ci::RaiseCppStandard(&app), "service raises C++14");
+    Expect(app.cpp_standard == 17, "service needs C++17");
+  }
+  {
+    ci::AppParams app;
+    app.cpp_standard = 23;
+    app.embed_resources = true;
+    Expect(!ci::RaiseCppStandard(&app), "C++23 isn't lowered");
+    Expect(app.cpp_standard == 23, "C++23 is kept");
+  }
+  {
+    ci::AppParams app;
+    app.cpp_standard = 11;
+    Expect(!ci::RaiseCppStandard(&app), "empty app keeps C++11");
+    Expect(app.cpp_standard == 11, "empty app is C++11");
+  }
+  {
+    ci::LibraryParams lib;
+    lib.cpp_standard = 98;
+    lib.profile = ci::LibraryProfile::kConcurrency;
+    Expect(ci::RaiseCppStandard(&lib), "concurrency raises C++98");
+    Expect(lib.cpp_standard == 17, "concurrency needs C++17");
+  }
+  {
+    ci::LibraryParams lib;
+    lib.cpp_standard = 11;
+    lib.build_config = true;
+    Expect(ci::RaiseCppStandard(&lib), "build_config raises C++11");
+    Expect(lib.cpp_standard == 17, "build_config needs C++17");
+  }
+  {
+    ci::SuperProjectParams super;
+    ci::LibraryParams lib;
+    lib.cpp_standard = 14;
+    ci::AppParams app;
+    app.cpp_standard = 17;
+    app.embed_resources = true;
+    super.Add(&lib);
+    super.Add(&app);
+    Expect(super.cpp_standard == 20, "super project uses the raised standard");
+  }
+  return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}